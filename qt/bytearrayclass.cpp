@@ -92,6 +92,9 @@ ByteArrayClass::ByteArrayClass(QScriptEngine *engine)
 
     ctor = engine->newFunction(construct, proto);
     ctor.setData(engine->toScriptValue(this));
+
+    // Avoid looking up global "ByteArray" for each converted value.
+    engine->setProperty("ByteArrayClass", QVariant::fromValue(this));
 }
 //! [0]
 
@@ -226,10 +229,20 @@ QScriptValue ByteArrayClass::construct(QScriptContext *ctx, QScriptEngine *)
 }
 //! [2]
 
+void ByteArrayClass::reportGrowth(int oldSize, int newSize)
+{
+    if (newSize > oldSize)
+        engine()->reportAdditionalMemoryCost(newSize - oldSize);
+}
+
+ByteArrayClass *ByteArrayClass::fromEngine(QScriptEngine *eng)
+{
+    return eng->property("ByteArrayClass").value<ByteArrayClass*>();
+}
+
 QScriptValue ByteArrayClass::toScriptValue(QScriptEngine *eng, const QByteArray &ba)
 {
-    QScriptValue ctor = eng->globalObject().property("ByteArray");
-    ByteArrayClass *cls = qscriptvalue_cast<ByteArrayClass*>(ctor.data());
+    ByteArrayClass *cls = fromEngine(eng);
     if (!cls)
         return eng->newVariant(QVariant::fromValue(ba));
     return cls->newInstance(ba);
@@ -237,8 +250,7 @@ QScriptValue ByteArrayClass::toScriptValue(QScriptEngine *eng, const QByteArray
 
 QScriptValue ByteArrayClass::toScriptValueFromString(QScriptEngine *eng, const QString &str)
 {
-    QScriptValue ctor = eng->globalObject().property("ByteArray");
-    ByteArrayClass *cls = qscriptvalue_cast<ByteArrayClass*>(ctor.data());
+    ByteArrayClass *cls = fromEngine(eng);
     if (!cls)
         return eng->newVariant(QVariant::fromValue(str));
     return cls->newInstance(str.toUtf8());
@@ -246,12 +258,25 @@ QScriptValue ByteArrayClass::toScriptValueFromString(QScriptEngine *eng, const Q
 
 void ByteArrayClass::fromScriptValue(const QScriptValue &obj, QByteArray &ba)
 {
-    ba = qvariant_cast<QByteArray>(obj.data().toVariant());
+    // Share data with ByteArray object instead of copying it through QVariant.
+    const QByteArray *bytes = qscriptvalue_cast<QByteArray*>(obj.data());
+    if (bytes)
+        ba = *bytes;
+    else if ( obj.isString() )
+        ba = obj.toString().toUtf8();
+    else
+        ba = qvariant_cast<QByteArray>(obj.data().toVariant());
 }
 
 void ByteArrayClass::fromScriptValueToString(const QScriptValue &obj, QString &str)
 {
-    str = qvariant_cast<QByteArray>(obj.data().toVariant());
+    const QByteArray *bytes = qscriptvalue_cast<QByteArray*>(obj.data());
+    if (bytes)
+        str = QString::fromUtf8( bytes->constData(), bytes->size() );
+    else if ( obj.isString() )
+        str = obj.toString();
+    else
+        str = qvariant_cast<QByteArray>(obj.data().toVariant());
 }
 
 //! [9]
@@ -259,8 +284,7 @@ void ByteArrayClass::resize(QByteArray &ba, int newSize)
 {
     int oldSize = ba.size();
     ba.resize(newSize);
-    if (newSize > oldSize)
-        engine()->reportAdditionalMemoryCost(newSize - oldSize);
+    reportGrowth(oldSize, newSize);
 }
 //! [9]
 
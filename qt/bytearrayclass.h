@@ -80,7 +80,11 @@ public:
 
     QScriptValue prototype() const;
 
+    void reportGrowth(int oldSize, int newSize);
+
 private:
+    static ByteArrayClass *fromEngine(QScriptEngine *eng);
+
     static QScriptValue construct(QScriptContext *ctx, QScriptEngine *eng);
 
     static QScriptValue toScriptValue(QScriptEngine *eng, const QByteArray &ba);
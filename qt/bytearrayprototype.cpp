@@ -39,6 +39,7 @@
 ****************************************************************************/
 
 #include "bytearrayprototype.h"
+#include "bytearrayclass.h"
 #include <QtScript/QScriptEngine>
 
 Q_DECLARE_METATYPE(QByteArray*)
@@ -59,6 +60,25 @@ QByteArray *ByteArrayPrototype::thisByteArray() const
 }
 //! [0]
 
+QScriptValue ByteArrayPrototype::append(const QScriptValue &value)
+{
+    // Append in place so building large output in a loop doesn't copy the data each time.
+    QByteArray *ba = thisByteArray();
+    const int oldSize = ba->size();
+
+    const QByteArray *other = qscriptvalue_cast<QByteArray*>(value.data());
+    if (other)
+        ba->append(*other);
+    else
+        ba->append( value.toString().toUtf8() );
+
+    ByteArrayClass *cls = qobject_cast<ByteArrayClass*>(parent());
+    if (cls)
+        cls->reportGrowth(oldSize, ba->size());
+
+    return thisObject();
+}
+
 void ByteArrayPrototype::chop(int n)
 {
     thisByteArray()->chop(n);
@@ -55,6 +55,7 @@ public:
     ~ByteArrayPrototype();
 
 public slots:
+    QScriptValue append(const QScriptValue &value);
     void chop(int n);
     bool equals(const QByteArray &other);
     QByteArray left(int len) const;
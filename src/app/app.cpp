@@ -19,6 +19,7 @@
 
 #include "app.h"
 
+#include "common/action.h"
 #include "common/log.h"
 #include "common/settings.h"
 #include "platform/platformnativeinterface.h"
@@ -194,6 +195,7 @@ App::App(QCoreApplication *application,
 
     qputenv("COPYQ_SESSION_NAME", sessionName.toUtf8());
     qputenv("COPYQ", QCoreApplication::applicationFilePath().toUtf8());
+    Action::resetEnvironment();
 
     QCoreApplication::setOrganizationName(session);
     QCoreApplication::setApplicationName(session);
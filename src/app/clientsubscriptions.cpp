@@ -0,0 +1,123 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clientsubscriptions.h"
+
+#include "common/clientsocket.h"
+#include "common/commandstatus.h"
+#include "common/log.h"
+
+namespace {
+
+const char *const eventNames[] = { "clipboard", "added", "removed", "renamed" };
+
+const int eventCount = sizeof(eventNames) / sizeof(eventNames[0]);
+
+} // namespace
+
+ClientSubscriptions::ClientSubscriptions(QObject *parent)
+    : QObject(parent)
+{
+}
+
+bool ClientSubscriptions::subscribe(ClientSocket *client, const QStringList &events, QString *error)
+{
+    int mask = events.isEmpty() ? AllEvents : 0;
+
+    foreach (const QString &eventName, events) {
+        int i = 0;
+        while ( i < eventCount && eventName != eventNames[i] )
+            ++i;
+
+        if (i == eventCount) {
+            *error = tr("Unknown event \"%1\" (available events are: %2).")
+                    .arg(eventName)
+                    .arg("clipboard, added, removed, renamed");
+            return false;
+        }
+
+        mask |= 1 << i;
+    }
+
+    m_clients.insert(client, mask);
+
+    connect( client, SIGNAL(disconnected()),
+             this, SLOT(onClientDisconnected()) );
+    connect( client, SIGNAL(destroyed()),
+             this, SLOT(onClientDisconnected()) );
+
+    client->deleteAfterDisconnected();
+    client->start();
+
+    COPYQ_LOG( QString("Client subscribed (%1 subscribers)").arg(m_clients.size()) );
+
+    client->sendMessage("subscribed\n", CommandSuccess);
+
+    return true;
+}
+
+void ClientSubscriptions::onClipboardChanged(const QVariantMap &data)
+{
+    notify( ClipboardChanged, QStringList() << "clipboard" << QStringList(data.keys()).join(",") );
+}
+
+void ClientSubscriptions::onItemsAdded(const QString &tabName, int row, int count)
+{
+    notify( ItemsAdded, QStringList() << "added" << tabName
+            << QString::number(row) << QString::number(count) );
+}
+
+void ClientSubscriptions::onItemsRemoved(const QString &tabName, int row, int count)
+{
+    notify( ItemsRemoved, QStringList() << "removed" << tabName
+            << QString::number(row) << QString::number(count) );
+}
+
+void ClientSubscriptions::onTabRenamed(const QString &newName, const QString &oldName)
+{
+    notify( TabRenamed, QStringList() << "renamed" << newName << oldName );
+}
+
+void ClientSubscriptions::onClientDisconnected()
+{
+    // Socket can be already partially destroyed so it's only used as a key.
+    ClientSocket *client = static_cast<ClientSocket*>( sender() );
+    if ( m_clients.remove(client) > 0 )
+        COPYQ_LOG( QString("Client unsubscribed (%1 subscribers)").arg(m_clients.size()) );
+}
+
+void ClientSubscriptions::notify(Event event, const QStringList &fields)
+{
+    if ( m_clients.isEmpty() )
+        return;
+
+    QByteArray message;
+
+    for ( QMap<ClientSocket*, int>::const_iterator it = m_clients.constBegin();
+          it != m_clients.constEnd(); ++it )
+    {
+        if ( (it.value() & event) == 0 )
+            continue;
+
+        if ( message.isEmpty() )
+            message = fields.join("\t").toUtf8() + '\n';
+
+        it.key()->sendMessage(message, CommandSuccess);
+    }
+}
@@ -0,0 +1,80 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLIENTSUBSCRIPTIONS_H
+#define CLIENTSUBSCRIPTIONS_H
+
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+
+class ClientSocket;
+
+/**
+ * Sends events to subscribed clients.
+ *
+ * Client started with "subscribe" command keeps connection open and
+ * receives a line for each event (fields are separated by tab character):
+ *
+ *   - "subscribed" after subscription is active,
+ *   - "clipboard" followed by available formats when clipboard changes,
+ *   - "added", tab name, first row and number of items when items are added,
+ *   - "removed", tab name, first row and number of items when items are removed,
+ *   - "renamed", new tab name and old tab name when tab is renamed.
+ */
+class ClientSubscriptions : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ClientSubscriptions(QObject *parent = NULL);
+
+    /**
+     * Subscribe client to given events (all events if @a events is empty).
+     *
+     * Returns false and sets @a error if an event name is unknown.
+     * Client socket is deleted after it disconnects.
+     */
+    bool subscribe(ClientSocket *client, const QStringList &events, QString *error);
+
+public slots:
+    void onClipboardChanged(const QVariantMap &data);
+    void onItemsAdded(const QString &tabName, int row, int count);
+    void onItemsRemoved(const QString &tabName, int row, int count);
+    void onTabRenamed(const QString &newName, const QString &oldName);
+
+private slots:
+    void onClientDisconnected();
+
+private:
+    enum Event {
+        ClipboardChanged = 0x1,
+        ItemsAdded = 0x2,
+        ItemsRemoved = 0x4,
+        TabRenamed = 0x8,
+        AllEvents = 0xf
+    };
+
+    void notify(Event event, const QStringList &fields);
+
+    QMap<ClientSocket*, int> m_clients; ///< Subscribed events for each client.
+};
+
+#endif // CLIENTSUBSCRIPTIONS_H
@@ -0,0 +1,108 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clipboardchangecoalescer.h"
+
+#include "common/clipboardchangestatistics.h"
+#include "common/common.h"
+#include "common/log.h"
+
+namespace {
+
+const char propertyMode[] = "CopyQ_clipboard_mode";
+
+/// Report change at least after this interval (in ms) even if changes keep coming.
+const int maxDelay = 1000;
+
+} // namespace
+
+ClipboardChangeCoalescer::ClipboardChangeCoalescer(QObject *parent)
+    : QObject(parent)
+    , m_delay(0)
+    , m_minInterval(0)
+    , m_coalescedCount(0)
+    , m_droppedCount(0)
+{
+    for (int mode = 0; mode < 3; ++mode) {
+        QTimer *timer = &m_modes[mode].timer;
+        initSingleShotTimer(timer, 0, this, SLOT(onTimeout()));
+        timer->setProperty(propertyMode, mode);
+    }
+}
+
+void ClipboardChangeCoalescer::setDelay(int ms)
+{
+    m_delay = qMax(0, ms);
+}
+
+void ClipboardChangeCoalescer::setMaximumRate(int changesPerSecond)
+{
+    m_minInterval = changesPerSecond > 0 ? 1000 / changesPerSecond : 0;
+}
+
+void ClipboardChangeCoalescer::onChanged(PlatformClipboard::Mode mode)
+{
+    ModeState &state = m_modes[mode];
+
+    if ( m_delay == 0 && m_minInterval == 0 && !state.pending ) {
+        emit changed(mode);
+        return;
+    }
+
+    if (state.pending) {
+        if (state.rateLimited)
+            ++m_droppedCount;
+        else
+            ++m_coalescedCount;
+        ClipboardChangeStatistics::setCounts(m_coalescedCount, m_droppedCount);
+    } else {
+        state.pending = true;
+        state.firstPending.start();
+    }
+
+    // Wait for more changes but not indefinitely.
+    int wait = qMin( m_delay, qMax(maxDelay, m_delay) - static_cast<int>(state.firstPending.elapsed()) );
+
+    // Don't report changes too often.
+    state.rateLimited = false;
+    if ( m_minInterval > 0 && state.lastEmitted.isValid() ) {
+        const int rateWait = m_minInterval - static_cast<int>(state.lastEmitted.elapsed());
+        if (rateWait > wait) {
+            wait = rateWait;
+            state.rateLimited = true;
+        }
+    }
+
+    state.timer.start( qMax(0, wait) );
+}
+
+void ClipboardChangeCoalescer::onTimeout()
+{
+    const int mode = sender()->property(propertyMode).toInt();
+    ModeState &state = m_modes[mode];
+    state.pending = false;
+    state.rateLimited = false;
+    state.lastEmitted.start();
+
+    COPYQ_LOG( QString("Clipboard changes coalesced: %1, dropped: %2")
+               .arg(m_coalescedCount)
+               .arg(m_droppedCount) );
+
+    emit changed( static_cast<PlatformClipboard::Mode>(mode) );
+}
@@ -0,0 +1,83 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLIPBOARDCHANGECOALESCER_H
+#define CLIPBOARDCHANGECOALESCER_H
+
+#include "platform/platformclipboard.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+/**
+ * Merges bursts of clipboard change notifications.
+ *
+ * Each clipboard mode is handled separately. Signal changed() is emitted only
+ * after there was no other change for given delay and at most given number of
+ * times per second. Intermediate changes are not reported.
+ *
+ * If neither delay nor maximum rate is set, every change is reported immediately.
+ */
+class ClipboardChangeCoalescer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ClipboardChangeCoalescer(QObject *parent = NULL);
+
+    /// Set interval (in ms) to wait for another change.
+    void setDelay(int ms);
+
+    /// Set maximum number of reported changes per second for each mode (zero for unlimited).
+    void setMaximumRate(int changesPerSecond);
+
+    /// Number of changes merged with following change within delay.
+    quint64 coalescedCount() const { return m_coalescedCount; }
+
+    /// Number of changes merged with following change because of rate limit.
+    quint64 droppedCount() const { return m_droppedCount; }
+
+public slots:
+    void onChanged(PlatformClipboard::Mode mode);
+
+signals:
+    void changed(PlatformClipboard::Mode mode);
+
+private slots:
+    void onTimeout();
+
+private:
+    struct ModeState {
+        ModeState() : pending(false), rateLimited(false) {}
+        QTimer timer;
+        QElapsedTimer lastEmitted;
+        QElapsedTimer firstPending;
+        bool pending;
+        bool rateLimited;
+    };
+
+    ModeState m_modes[3];
+    int m_delay;
+    int m_minInterval;
+    quint64 m_coalescedCount;
+    quint64 m_droppedCount;
+};
+
+#endif // CLIPBOARDCHANGECOALESCER_H
@@ -26,23 +26,71 @@
 #include "platform/platformnativeinterface.h"
 #include "platform/platformwindow.h"
 
-#include <QCoreApplication>
+#include <QDataStream>
 #include <QFile>
+#include <QLocalSocket>
+
+namespace {
+
+bool receiveMessage(QLocalSocket *socket, QByteArray *data, int *messageCode)
+{
+    // Command can run for long time so wait for next message indefinitely.
+    QByteArray msg;
+    return readMessage(socket, &msg, -1) && parseMessage(msg, data, messageCode);
+}
+
+bool sendMessage(QLocalSocket *socket, const QByteArray &data, int messageCode)
+{
+    if ( !writeMessage(socket, createMessage(data, messageCode)) )
+        return false;
+
+    // Client doesn't run event loop so the message must be flushed here.
+    while ( socket->bytesToWrite() > 0 ) {
+        if ( !socket->waitForBytesWritten(socketTimeoutMs) )
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace
 
 ClipboardClient::ClipboardClient(int &argc, char **argv, int skipArgc, const QString &sessionName)
-    : Client()
-    , App(createPlatformNativeInterface()->createClientApplication(argc, argv), sessionName)
+    : App(createPlatformNativeInterface()->createClientApplication(argc, argv), sessionName)
 {
     Arguments arguments(
                 createPlatformNativeInterface()->getCommandLineArguments(argc, argv)
                 .mid(skipArgc) );
-    if ( !startClientSocket(clipboardServerName(), arguments) ) {
+    exit( runCommand(arguments) );
+}
+
+int ClipboardClient::runCommand(const Arguments &arguments)
+{
+    QLocalSocket socket;
+    socket.connectToServer( clipboardServerName() );
+    if ( !socket.waitForConnected(socketTimeoutMs) ) {
         log( tr("Cannot connect to server! Start CopyQ server first."), LogError );
-        exit(1);
+        return 1;
+    }
+
+    QByteArray msg;
+    QDataStream out(&msg, QIODevice::WriteOnly);
+    out << arguments;
+
+    if ( sendMessage(&socket, msg, 0) ) {
+        QByteArray data;
+        int messageCode;
+        while ( receiveMessage(&socket, &data, &messageCode) ) {
+            if ( handleMessage(&socket, data, messageCode) )
+                return messageCode;
+        }
     }
+
+    log( tr("Connection lost!"), LogError );
+    return 1;
 }
 
-void ClipboardClient::onMessageReceived(const QByteArray &data, int messageCode)
+bool ClipboardClient::handleMessage(QLocalSocket *socket, const QByteArray &data, int messageCode)
 {
     if (messageCode == CommandActivateWindow) {
         COPYQ_LOG("Activating window.");
@@ -53,7 +101,8 @@ void ClipboardClient::onMessageReceived(const QByteArray &data, int messageCode)
         COPYQ_LOG("Sending standard input.");
         QFile in;
         in.open(stdin, QIODevice::ReadOnly);
-        sendMessage( in.readAll(), 0 );
+        // Failure is reported when reading next message.
+        sendMessage(socket, in.readAll(), 0);
     } else {
         QFile f;
         f.open((messageCode == CommandSuccess || messageCode == CommandFinished) ? stdout : stderr, QIODevice::WriteOnly);
@@ -62,15 +111,5 @@ void ClipboardClient::onMessageReceived(const QByteArray &data, int messageCode)
 
     COPYQ_LOG( QString("Message received with exit code %1.").arg(messageCode) );
 
-    if (messageCode == CommandFinished || messageCode == CommandBadSyntax || messageCode == CommandError)
-        exit(messageCode);
-}
-
-void ClipboardClient::onDisconnected()
-{
-    if ( wasClosed() )
-        return;
-
-    log( tr("Connection lost!"), LogError );
-    exit(1);
+    return messageCode == CommandFinished || messageCode == CommandBadSyntax || messageCode == CommandError;
 }
@@ -21,7 +21,12 @@
 #define CLIPBOARDCLIENT_H
 
 #include "app.h"
-#include "client.h"
+
+#include <QCoreApplication>
+
+class Arguments;
+class QByteArray;
+class QLocalSocket;
 
 /**
  * Application client.
@@ -30,19 +35,24 @@
  * Exit code is same as exit code send by ClipboardServer::sendMessage().
  * Also the received message is printed on standard output (if exit code is
  * zero) or standard error output.
+ *
+ * Client uses blocking socket calls in main thread so no event loop and no
+ * extra thread is needed to pass a command to the server.
  */
-class ClipboardClient : public Client, public App
+class ClipboardClient : public App
 {
-    Q_OBJECT
+    Q_DECLARE_TR_FUNCTIONS(ClipboardClient)
 
 public:
     ClipboardClient(int &argc, char **argv,
                     int skipArgc = 0, const QString &sessionName = QString());
 
-private slots:
-    void onMessageReceived(const QByteArray &data, int messageCode);
+private:
+    /// Sends command to server and handles responses until it finishes; returns exit code.
+    int runCommand(const Arguments &arguments);
 
-    void onDisconnected();
+    /// Returns true if @a messageCode is the last message from server.
+    bool handleMessage(QLocalSocket *socket, const QByteArray &data, int messageCode);
 };
 
 #endif // CLIPBOARDCLIENT_H
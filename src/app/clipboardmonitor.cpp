@@ -21,35 +21,16 @@
 
 #include "common/arguments.h"
 #include "common/log.h"
-#include "common/mimetypes.h"
 #include "common/monitormessagecode.h"
 #include "item/serialize.h"
-#include "platform/platformclipboard.h"
 
 #include <QApplication>
 
-namespace {
-
-bool hasSameData(const QVariantMap &data, const QVariantMap &lastData)
-{
-    foreach (const QString &format, data.keys()) {
-        if ( !format.startsWith(COPYQ_MIME_PREFIX)
-             && !data[format].toByteArray().isEmpty()
-             && data[format] != lastData.value(format) )
-        {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-} // namespace
-
 ClipboardMonitor::ClipboardMonitor(int &argc, char **argv)
     : Client()
     , App(createPlatformNativeInterface()->createMonitorApplication(argc, argv))
-    , m_clipboard(createPlatformNativeInterface()->clipboard())
+    , m_worker(new ClipboardMonitorWorker(this))
+    , m_reportedChangeCount(0)
 {
     Q_ASSERT(argc == 3);
     const QString serverName( QString::fromUtf8(argv[2]) );
@@ -59,35 +40,35 @@ ClipboardMonitor::ClipboardMonitor(int &argc, char **argv)
         QCoreApplication::instance()->setProperty("CopyQ_testing", true);
 #endif
 
+    connect( m_worker, SIGNAL(clipboardChanged(QVariantMap)),
+             this, SLOT(onClipboardChanged(QVariantMap)) );
+    connect( &m_worker->coalescer(), SIGNAL(changed(PlatformClipboard::Mode)),
+             this, SLOT(sendStatistics()) );
+
     Arguments arguments(
                 createPlatformNativeInterface()->getCommandLineArguments(argc, argv) );
     if ( !startClientSocket(serverName, arguments) )
         exit(1);
 }
 
-void ClipboardMonitor::onClipboardChanged(PlatformClipboard::Mode mode)
+void ClipboardMonitor::onClipboardChanged(const QVariantMap &data)
 {
-    QVariantMap data = m_clipboard->data(mode, m_formats);
-    QVariantMap &lastData = m_lastData[mode];
+    sendMessage( serializeData(data), MonitorClipboardChanged );
+}
 
-    if ( hasSameData(data, lastData) ) {
-        COPYQ_LOG("Ignoring unchanged clipboard content");
+void ClipboardMonitor::sendStatistics()
+{
+    const ClipboardChangeCoalescer &coalescer = m_worker->coalescer();
+    const quint64 changeCount = coalescer.coalescedCount() + coalescer.droppedCount();
+    if (changeCount == m_reportedChangeCount)
         return;
-    }
 
-    if (mode != PlatformClipboard::Clipboard)
-        data.insert(mimeClipboardMode, PlatformClipboard::Selection ? "selection" : "find buffer");
+    m_reportedChangeCount = changeCount;
 
-    // add window title of clipboard owner
-    if ( !data.contains(mimeOwner) && !data.contains(mimeWindowTitle) ) {
-        PlatformPtr platform = createPlatformNativeInterface();
-        PlatformWindowPtr currentWindow = platform->getCurrentWindow();
-        if (currentWindow)
-            data.insert( mimeWindowTitle, currentWindow->getTitle().toUtf8() );
-    }
-
-    sendMessage( serializeData(data), MonitorClipboardChanged );
-    lastData = data;
+    QByteArray message;
+    QDataStream stream(&message, QIODevice::WriteOnly);
+    stream << coalescer.coalescedCount() << coalescer.droppedCount();
+    sendMessage(message, MonitorStatistics);
 }
 
 void ClipboardMonitor::onMessageReceived(const QByteArray &message, int messageCode)
@@ -98,36 +79,16 @@ void ClipboardMonitor::onMessageReceived(const QByteArray &message, int messageC
         QVariantMap settings;
         QDataStream stream(message);
         stream >> settings;
-
-        if ( hasLogLevel(LogDebug) ) {
-            COPYQ_LOG("Loading configuration:");
-            foreach (const QString &key, settings.keys()) {
-                const QVariant val = settings[key];
-                const QString str = val.canConvert<QStringList>() ? val.toStringList().join(",")
-                                                                  : val.toString();
-                COPYQ_LOG( QString(" %1=%2").arg(key).arg(str) );
-            }
-        }
-
-        if ( settings.contains("formats") )
-            m_formats = settings["formats"].toStringList();
-
-        connect( m_clipboard.data(), SIGNAL(changed(PlatformClipboard::Mode)),
-                 this, SLOT(onClipboardChanged(PlatformClipboard::Mode)),
-                 Qt::UniqueConnection );
-
-        m_clipboard->loadSettings(settings);
-
-        COPYQ_LOG("Configured");
+        m_worker->loadSettings(settings);
     } else if (messageCode == MonitorChangeClipboard
             || messageCode == MonitorChangeSelection)
     {
         QVariantMap data;
         deserializeData(&data, message);
         if (messageCode == MonitorChangeClipboard)
-            m_clipboard->setData(PlatformClipboard::Clipboard, data);
+            m_worker->setClipboard(data, PlatformClipboard::Clipboard);
         if (messageCode == MonitorChangeSelection)
-            m_clipboard->setData(PlatformClipboard::Selection, data);
+            m_worker->setClipboard(data, PlatformClipboard::Selection);
     } else {
         log( QString("Unknown message code %1!").arg(messageCode), LogError );
     }
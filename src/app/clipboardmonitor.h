@@ -22,8 +22,7 @@
 
 #include "app.h"
 #include "client.h"
-
-#include "platform/platformnativeinterface.h"
+#include "clipboardmonitorworker.h"
 
 /**
  * Monitors clipboard and sends new clipboard data to server.
@@ -42,16 +41,18 @@ public:
     ClipboardMonitor(int &argc, char **argv);
 
 private slots:
-    void onClipboardChanged(PlatformClipboard::Mode mode);
+    void onClipboardChanged(const QVariantMap &data);
+
+    /// Send counts of coalesced and dropped clipboard changes to server.
+    void sendStatistics();
 
     void onMessageReceived(const QByteArray &message, int messageCode);
 
     void onDisconnected();
 
 private:
-    PlatformClipboardPtr m_clipboard;
-    QStringList m_formats;
-    QVariantMap m_lastData[3]; /// Last data sent for each clipboard mode
+    ClipboardMonitorWorker *m_worker;
+    quint64 m_reportedChangeCount;
 };
 
 #endif // CLIPBOARDMONITOR_H
@@ -0,0 +1,114 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clipboardmonitorworker.h"
+
+#include "common/log.h"
+#include "common/mimetypes.h"
+#include "platform/platformclipboard.h"
+#include "platform/platformwindow.h"
+
+#include <QStringList>
+
+namespace {
+
+bool hasSameData(const QVariantMap &data, const QVariantMap &lastData)
+{
+    foreach (const QString &format, data.keys()) {
+        if ( !format.startsWith(COPYQ_MIME_PREFIX)
+             && !data[format].toByteArray().isEmpty()
+             && data[format] != lastData.value(format) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+ClipboardMonitorWorker::ClipboardMonitorWorker(QObject *parent)
+    : QObject(parent)
+    , m_clipboard(createPlatformNativeInterface()->clipboard())
+{
+    qRegisterMetaType<QVariantMap>("QVariantMap");
+}
+
+void ClipboardMonitorWorker::loadSettings(const QVariantMap &settings)
+{
+    if ( hasLogLevel(LogDebug) ) {
+        COPYQ_LOG("Loading configuration:");
+        foreach (const QString &key, settings.keys()) {
+            const QVariant val = settings[key];
+            const QString str = val.canConvert<QStringList>() ? val.toStringList().join(",")
+                                                              : val.toString();
+            COPYQ_LOG( QString(" %1=%2").arg(key).arg(str) );
+        }
+    }
+
+    if ( settings.contains("formats") )
+        m_formats = settings["formats"].toStringList();
+
+    if ( settings.contains("change_delay") )
+        m_coalescer.setDelay( settings["change_delay"].toInt() );
+    if ( settings.contains("max_change_rate") )
+        m_coalescer.setMaximumRate( settings["max_change_rate"].toInt() );
+
+    connect( m_clipboard.data(), SIGNAL(changed(PlatformClipboard::Mode)),
+             &m_coalescer, SLOT(onChanged(PlatformClipboard::Mode)),
+             Qt::UniqueConnection );
+    connect( &m_coalescer, SIGNAL(changed(PlatformClipboard::Mode)),
+             this, SLOT(onClipboardChanged(PlatformClipboard::Mode)),
+             Qt::UniqueConnection );
+
+    m_clipboard->loadSettings(settings);
+
+    COPYQ_LOG("Configured");
+}
+
+void ClipboardMonitorWorker::setClipboard(const QVariantMap &data, PlatformClipboard::Mode mode)
+{
+    m_clipboard->setData(mode, data);
+}
+
+void ClipboardMonitorWorker::onClipboardChanged(PlatformClipboard::Mode mode)
+{
+    QVariantMap data = m_clipboard->data(mode, m_formats);
+    QVariantMap &lastData = m_lastData[mode];
+
+    if ( hasSameData(data, lastData) ) {
+        COPYQ_LOG("Ignoring unchanged clipboard content");
+        return;
+    }
+
+    if (mode != PlatformClipboard::Clipboard)
+        data.insert(mimeClipboardMode, PlatformClipboard::Selection ? "selection" : "find buffer");
+
+    // add window title of clipboard owner
+    if ( !data.contains(mimeOwner) && !data.contains(mimeWindowTitle) ) {
+        PlatformPtr platform = createPlatformNativeInterface();
+        PlatformWindowPtr currentWindow = platform->getCurrentWindow();
+        if (currentWindow)
+            data.insert( mimeWindowTitle, currentWindow->getTitle().toUtf8() );
+    }
+
+    lastData = data;
+    emit clipboardChanged(data);
+}
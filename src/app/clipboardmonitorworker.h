@@ -0,0 +1,69 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLIPBOARDMONITORWORKER_H
+#define CLIPBOARDMONITORWORKER_H
+
+#include "clipboardchangecoalescer.h"
+
+#include "platform/platformnativeinterface.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+
+/**
+ * Watches clipboard and reports new clipboard data.
+ *
+ * Used by ClipboardMonitor process or directly by server if monitor runs
+ * in the server process.
+ *
+ * Object must live in the main thread since platform clipboard cannot be
+ * accessed from other threads. Connect clipboardChanged() signal with
+ * Qt::QueuedConnection to process new data outside clipboard change handler.
+ */
+class ClipboardMonitorWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ClipboardMonitorWorker(QObject *parent = NULL);
+
+    const ClipboardChangeCoalescer &coalescer() const { return m_coalescer; }
+
+public slots:
+    /// Load settings (see PlatformClipboard::loadSettings()) and start monitoring.
+    void loadSettings(const QVariantMap &settings);
+
+    void setClipboard(const QVariantMap &data, PlatformClipboard::Mode mode);
+
+signals:
+    void clipboardChanged(const QVariantMap &data);
+
+private slots:
+    void onClipboardChanged(PlatformClipboard::Mode mode);
+
+private:
+    PlatformClipboardPtr m_clipboard;
+    ClipboardChangeCoalescer m_coalescer;
+    QStringList m_formats;
+    QVariantMap m_lastData[3]; /// Last data sent for each clipboard mode
+};
+
+#endif // CLIPBOARDMONITORWORKER_H
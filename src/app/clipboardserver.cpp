@@ -19,10 +19,12 @@
 
 #include "clipboardserver.h"
 
+#include "app/clipboardmonitorworker.h"
 #include "app/remoteprocess.h"
 #include "common/arguments.h"
 #include "common/clientsocket.h"
 #include "common/client_server.h"
+#include "common/commandstatus.h"
 #include "common/log.h"
 #include "common/mimetypes.h"
 #include "common/monitormessagecode.h"
@@ -69,9 +71,11 @@ ClipboardServer::ClipboardServer(int &argc, char **argv, const QString &sessionN
           sessionName, true)
     , m_wnd(NULL)
     , m_monitor(NULL)
+    , m_localMonitor(NULL)
     , m_shortcutActions()
     , m_shortcutBlocker()
     , m_clientThreads()
+    , m_subscriptions()
     , m_ignoreKeysTimer()
 {
     Server *server = new Server( clipboardServerName(), this );
@@ -87,6 +91,8 @@ ClipboardServer::ClipboardServer(int &argc, char **argv, const QString &sessionN
 
     m_wnd = new MainWindow;
 
+    Action::setScriptRunner(this);
+
     connect( server, SIGNAL(newConnection(Arguments,ClientSocket*)),
              this, SLOT(doCommand(Arguments,ClientSocket*)) );
 
@@ -102,6 +108,13 @@ ClipboardServer::ClipboardServer(int &argc, char **argv, const QString &sessionN
     connect( m_wnd, SIGNAL(requestExit()),
              this, SLOT(maybeQuit()) );
 
+    connect( m_wnd, SIGNAL(itemsAdded(QString,int,int)),
+             &m_subscriptions, SLOT(onItemsAdded(QString,int,int)) );
+    connect( m_wnd, SIGNAL(itemsRemoved(QString,int,int)),
+             &m_subscriptions, SLOT(onItemsRemoved(QString,int,int)) );
+    connect( m_wnd, SIGNAL(tabRenamed(QString,QString)),
+             &m_subscriptions, SLOT(onTabRenamed(QString,QString)) );
+
     loadSettings();
 
     // notify window if configuration changes
@@ -114,9 +127,6 @@ ClipboardServer::ClipboardServer(int &argc, char **argv, const QString &sessionN
     createGlobalShortcuts();
 #endif
 
-    // Allow to run at least few client and internal threads concurrently.
-    m_clientThreads.setMaxThreadCount( qMax(m_clientThreads.maxThreadCount(), 8) );
-
     // run clipboard monitor
     startMonitoring();
 
@@ -130,19 +140,28 @@ ClipboardServer::ClipboardServer(int &argc, char **argv, const QString &sessionN
 
 ClipboardServer::~ClipboardServer()
 {
+    Action::setScriptRunner(NULL);
     removeGlobalShortcuts();
     delete m_wnd;
 }
 
 void ClipboardServer::stopMonitoring()
 {
+    if (m_localMonitor != NULL) {
+        COPYQ_LOG("Clipboard Monitor: Stopping in-process monitor");
+        m_localMonitor->disconnect();
+        delete m_localMonitor;
+        m_localMonitor = NULL;
+    }
+
     if (m_monitor == NULL)
         return;
 
     COPYQ_LOG("Clipboard Monitor: Terminating");
 
+    // Monitor can be stopped from its own signal handler (e.g. on process exit).
     m_monitor->disconnect();
-    delete m_monitor;
+    m_monitor->deleteLater();
     m_monitor = NULL;
 
     COPYQ_LOG("Clipboard Monitor: Terminated");
@@ -152,7 +171,17 @@ void ClipboardServer::startMonitoring()
 {
     COPYQ_LOG("Starting monitor.");
 
-    if ( m_monitor == NULL ) {
+    if ( m_localMonitor == NULL && m_monitor == NULL
+         && ConfigurationManager::instance()->value("monitor_in_process").toBool() )
+    {
+        m_localMonitor = new ClipboardMonitorWorker(this);
+        // Process new data after clipboard change is handled.
+        connect( m_localMonitor, SIGNAL(clipboardChanged(QVariantMap)),
+                 this, SLOT(onClipboardChanged(QVariantMap)), Qt::QueuedConnection );
+        loadMonitorSettings();
+    }
+
+    if ( m_localMonitor == NULL && m_monitor == NULL ) {
         m_monitor = new RemoteProcess(this);
         connect( m_monitor, SIGNAL(newMessage(QByteArray)),
                  this, SLOT(newMonitorMessage(QByteArray)) );
@@ -179,10 +208,17 @@ void ClipboardServer::loadMonitorSettings()
 
     QVariantMap settings;
     settings["formats"] = cm->itemFactory()->formatsToSave();
+    settings["change_delay"] = cm->value("clipboard_change_delay");
+    settings["max_change_rate"] = cm->value("clipboard_max_change_rate");
 #ifdef COPYQ_WS_X11
     settings["check_selection"] = cm->value("check_selection");
 #endif
 
+    if (m_localMonitor) {
+        m_localMonitor->loadSettings(settings);
+        return;
+    }
+
     QByteArray settingsData;
     QDataStream settingsOut(&settingsData, QIODevice::WriteOnly);
     settingsOut << settings;
@@ -192,7 +228,7 @@ void ClipboardServer::loadMonitorSettings()
 
 bool ClipboardServer::isMonitoring()
 {
-    return m_monitor != NULL && m_monitor->isConnected();
+    return m_localMonitor != NULL || (m_monitor != NULL && m_monitor->isConnected());
 }
 
 void ClipboardServer::removeGlobalShortcuts()
@@ -230,7 +266,7 @@ void ClipboardServer::onAboutToQuit()
     if( isMonitoring() )
         stopMonitoring();
 
-    COPYQ_LOG( QString("Active client threads: %1").arg(m_clientThreads.activeThreadCount()) );
+    COPYQ_LOG( QString("Active client commands: %1").arg(m_clientThreads.activeCount()) );
 
     COPYQ_LOG("Terminating remaining threads.");
     emit terminateClientThreads();
@@ -265,7 +301,7 @@ bool ClipboardServer::askToQuit()
     if ( !m_wnd->maybeCloseCommandDialog() )
         return false;
 
-    if ( m_clientThreads.activeThreadCount() > 0 || m_wnd->hasRunningAction() ) {
+    if ( m_clientThreads.activeCount() > 0 || m_wnd->hasRunningAction() ) {
         QMessageBox messageBox( QMessageBox::Warning, tr("Cancel Active Commands"),
                                 tr("Cancel active commands and exit?"), QMessageBox::NoButton,
                                 m_wnd );
@@ -282,18 +318,54 @@ bool ClipboardServer::askToQuit()
 
 void ClipboardServer::doCommand(const Arguments &args, ClientSocket *client)
 {
+    // Subscribed client keeps connection open to receive events.
+    if ( client && args.length() > Arguments::Rest && args.at(Arguments::Rest) == "subscribe" ) {
+        QStringList events;
+        for ( int i = Arguments::Rest + 1; i < args.length(); ++i )
+            events.append( QString::fromUtf8(args.at(i)) );
+
+        QString error;
+        if ( m_subscriptions.subscribe(client, events, &error) ) {
+            connect( this, SIGNAL(terminateClientThreads()),
+                     client, SLOT(close()) );
+        } else {
+            client->sendMessage(
+                        createLogMessage("CopyQ client", error, LogError).toUtf8(), CommandError );
+            client->deleteAfterDisconnected();
+        }
+
+        return;
+    }
+
     // Worker object without parent needs to be deleted afterwards!
     // There is no parent so as it's possible to move the worker to another thread.
-    // QThreadPool takes ownership and worker will be automatically deleted
-    // after run() (see QRunnable::setAutoDelete()).
+    // The pool takes ownership and worker will be deleted after run().
     ScriptableWorker *worker = new ScriptableWorker(m_wnd, args, client);
 
+    QString source;
+    const ScriptableWorkerPool::Priority priority =
+            ScriptableWorkerPool::commandPriority(args, client, &source);
+
+    QString error;
+    if ( !m_clientThreads.start(worker, priority, source, &error) ) {
+        delete worker;
+        log(error, LogWarning);
+        if (client) {
+            client->sendMessage(
+                        createLogMessage("CopyQ client", error, LogError).toUtf8(), CommandError );
+            client->deleteAfterDisconnected();
+        }
+        return;
+    }
+
     // Terminate worker at application exit.
     connect( this, SIGNAL(terminateClientThreads()),
              client, SLOT(close()) );
+}
 
-    // Add client thread to pool.
-    m_clientThreads.start(worker);
+void ClipboardServer::runScript(const Arguments &args, ClientSocket *client)
+{
+    doCommand(args, client);
 }
 
 void ClipboardServer::newMonitorMessage(const QByteArray &message)
@@ -309,6 +381,15 @@ void ClipboardServer::newMonitorMessage(const QByteArray &message)
     }
 
     m_wnd->clipboardChanged(data);
+    m_subscriptions.onClipboardChanged(data);
+}
+
+void ClipboardServer::onClipboardChanged(const QVariantMap &data)
+{
+    if ( !m_wnd->isClipboardStoringDisabled() ) {
+        m_wnd->clipboardChanged(data);
+        m_subscriptions.onClipboardChanged(data);
+    }
 }
 
 void ClipboardServer::monitorConnectionError()
@@ -324,6 +405,14 @@ void ClipboardServer::changeClipboard(const QVariantMap &data, QClipboard::Mode
         return;
     }
 
+    if (m_localMonitor) {
+        const PlatformClipboard::Mode platformMode =
+                mode == QClipboard::Clipboard ? PlatformClipboard::Clipboard
+                                              : PlatformClipboard::Selection;
+        m_localMonitor->setClipboard(data, platformMode);
+        return;
+    }
+
     COPYQ_LOG("Sending message to monitor.");
 
     const MonitorMessageCode code =
@@ -374,9 +463,19 @@ bool ClipboardServer::eventFilter(QObject *object, QEvent *ev)
 
 void ClipboardServer::loadSettings()
 {
+    if ( !isMonitoring() )
+        return;
+
+    // restart clipboard monitor if it should run in other process
+    const bool inProcess = ConfigurationManager::instance()->value("monitor_in_process").toBool();
+    if ( inProcess != (m_localMonitor != NULL) ) {
+        stopMonitoring();
+        startMonitoring();
+        return;
+    }
+
     // reload clipboard monitor configuration
-    if ( isMonitoring() )
-        loadMonitorSettings();
+    loadMonitorSettings();
 }
 
 void ClipboardServer::shortcutActivated(QxtGlobalShortcut *shortcut)
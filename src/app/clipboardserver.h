@@ -21,19 +21,22 @@
 #define CLIPBOARDSERVER_H
 
 #include "app.h"
+#include "app/clientsubscriptions.h"
+#include "common/action.h"
 #include "common/server.h"
 #include "gui/configtabshortcuts.h"
 #include "gui/mainwindow.h"
+#include "scriptable/scriptableworkerpool.h"
 
 #include <QMap>
 #include <QProcess>
 #include <QTimer>
-#include <QThreadPool>
 #include <QVariantMap>
 #include <QWidget>
 
 class Arguments;
 class ClientSocket;
+class ClipboardMonitorWorker;
 class RemoteProcess;
 class QxtGlobalShortcut;
 class QSessionManager;
@@ -45,7 +48,7 @@ class QSessionManager;
  *
  * If user already run this server isListening() returns false.
  */
-class ClipboardServer : public QObject, public App
+class ClipboardServer : public QObject, public App, public ActionScriptRunner
 {
     Q_OBJECT
 
@@ -56,7 +59,12 @@ public:
     /** Stop monitor application. */
     void stopMonitoring();
 
-    /** Start monitor application. */
+    /**
+     * Start monitor application.
+     *
+     * If "monitor_in_process" option is set, clipboard is monitored directly
+     * in server process, otherwise separate monitor process is started.
+     */
     void startMonitoring();
 
     /** Return true if monitor is running. */
@@ -69,6 +77,9 @@ public:
      */
     void createGlobalShortcut(const QKeySequence &shortcut, const Command &command);
 
+    /** Evaluate "copyq:" script of an action without starting client process. */
+    void runScript(const Arguments &args, ClientSocket *client);
+
 public slots:
     /** Load @a item data to clipboard. */
     void changeClipboard(const QVariantMap &data, QClipboard::Mode mode);
@@ -97,6 +108,9 @@ private slots:
     /** New message from monitor process. */
     void newMonitorMessage(const QByteArray &message);
 
+    /** New clipboard data from monitor. */
+    void onClipboardChanged(const QVariantMap &data);
+
     /** An error occurred on monitor connection. */
     void monitorConnectionError();
 
@@ -126,9 +140,11 @@ private:
 
     MainWindow* m_wnd;
     RemoteProcess *m_monitor;
+    ClipboardMonitorWorker *m_localMonitor; ///< Monitor running in server process (optional).
     QMap<QxtGlobalShortcut*, Command> m_shortcutActions;
     QWidget m_shortcutBlocker;
-    QThreadPool m_clientThreads;
+    ScriptableWorkerPool m_clientThreads;
+    ClientSubscriptions m_subscriptions;
     QTimer m_ignoreKeysTimer;
 };
 
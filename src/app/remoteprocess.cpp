@@ -23,27 +23,48 @@
 #include "common/common.h"
 #include "common/client_server.h"
 #include "common/clientsocket.h"
+#include "common/clipboardchangestatistics.h"
 #include "common/monitormessagecode.h"
 #include "common/log.h"
 #include "common/server.h"
 
 #include <QCoreApplication>
 #include <QByteArray>
-#include <QProcess>
+#include <QDataStream>
 #include <QString>
 
+namespace {
+
+/// Interval (in ms) of inactivity before checking if remote process is responding.
+const int pingInterval = 30000;
+
+/// Interval (in ms) to wait for response to ping.
+const int pongTimeout = 4000;
+
+/// Interval (in ms) to wait for new remote process to connect.
+const int connectionTimeout = 8000;
+
+/// Interval (in ms) to wait for remote process to exit after closing connection.
+const int exitTimeout = 1000;
+
+} // namespace
+
 RemoteProcess::RemoteProcess(QObject *parent)
     : QObject(parent)
+    , m_process(NULL)
     , m_state(Unconnected)
 {
-    initSingleShotTimer( &m_timerPing, 8000, this, SLOT(ping()) );
-    initSingleShotTimer( &m_timerPongTimeout, 4000, this, SLOT(pongTimeout()) );
+    initSingleShotTimer( &m_timerPing, pingInterval, this, SLOT(ping()) );
+    initSingleShotTimer( &m_timerPongTimeout, pongTimeout, this, SLOT(pongTimeout()) );
+    initSingleShotTimer( &m_timerConnectionTimeout, connectionTimeout, this, SLOT(checkConnection()) );
 }
 
 RemoteProcess::~RemoteProcess()
 {
     m_timerPing.stop();
     m_timerPongTimeout.stop();
+    m_timerConnectionTimeout.stop();
+    stopProcess();
 }
 
 void RemoteProcess::start(const QString &newServerName, const QStringList &arguments)
@@ -53,6 +74,7 @@ void RemoteProcess::start(const QString &newServerName, const QStringList &argum
         return;
 
     m_state = Connecting;
+    m_startTime.start();
 
     Server *server = new Server(newServerName, this);
     if ( !server->isListening() ) {
@@ -72,21 +94,24 @@ void RemoteProcess::start(const QString &newServerName, const QStringList &argum
                .arg(QCoreApplication::applicationFilePath())
                .arg(arguments.join(" ")) );
 
-    qint64 monitorPid;
-    if ( !QProcess::startDetached(QCoreApplication::applicationFilePath(), arguments,
-                                  QString(), &monitorPid) )
-    {
-        log( "Remote process: Failed to start new remote process!", LogError );
-        onConnectionError();
-        return;
-    }
+    stopProcess();
+
+    // Keep the process as child to get notified immediately when it exits.
+    m_process = new QProcess(this);
+    m_process->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect( m_process, SIGNAL(error(QProcess::ProcessError)),
+             this, SLOT(onProcessError(QProcess::ProcessError)) );
+    connect( m_process, SIGNAL(finished(int)),
+             this, SLOT(onProcessFinished(int)) );
 
-    COPYQ_LOG( QString("Remote process: Started with pid %1.").arg(monitorPid) );
+    m_process->start(QCoreApplication::applicationFilePath(), arguments);
+    m_process->closeWriteChannel();
 
-    QTimer::singleShot(16000, this, SLOT(checkConnection()));
+    m_timerConnectionTimeout.start();
 }
 
-bool RemoteProcess::checkConnection() {
+bool RemoteProcess::checkConnection()
+{
     if (!isConnected()) {
         onConnectionError();
         return false;
@@ -97,7 +122,10 @@ bool RemoteProcess::checkConnection() {
 
 void RemoteProcess::onNewConnection(const Arguments &, ClientSocket *socket)
 {
-    COPYQ_LOG("Remote process: Started.");
+    COPYQ_LOG( QString("Remote process: Started in %1 ms.").arg(m_startTime.elapsed()) );
+
+    m_timerConnectionTimeout.stop();
+    m_socket = socket;
 
     connect( this, SIGNAL(destroyed()),
              socket, SLOT(deleteAfterDisconnected()) );
@@ -115,7 +143,7 @@ void RemoteProcess::onNewConnection(const Arguments &, ClientSocket *socket)
 
         socket->start();
 
-        ping();
+        m_timerPing.start();
 
         emit connected();
     }
@@ -123,17 +151,23 @@ void RemoteProcess::onNewConnection(const Arguments &, ClientSocket *socket)
 
 void RemoteProcess::onMessageReceived(const QByteArray &message, int messageCode)
 {
-    // restart waiting on ping response
-    if (m_timerPongTimeout.isActive())
-        m_timerPongTimeout.start();
+    // Any message means that the process is alive.
+    m_timerPongTimeout.stop();
+    m_timerPing.start();
 
     if (messageCode == MonitorPong) {
-        m_timerPongTimeout.stop();
-        m_timerPing.start();
+        COPYQ_LOG_VERBOSE("Remote process: Pong received.");
     } else if (messageCode == MonitorLog) {
         log( QString::fromUtf8(message).trimmed(), LogNote );
     } else if (messageCode == MonitorClipboardChanged) {
         emit newMessage(message);
+    } else if (messageCode == MonitorStatistics) {
+        quint64 coalescedCount;
+        quint64 droppedCount;
+        QDataStream stream(message);
+        stream >> coalescedCount >> droppedCount;
+        if ( stream.status() == QDataStream::Ok )
+            ClipboardChangeStatistics::setCounts(coalescedCount, droppedCount);
     } else {
         log( QString("Unknown message code %1 from remote process!").arg(messageCode), LogError );
     }
@@ -141,12 +175,66 @@ void RemoteProcess::onMessageReceived(const QByteArray &message, int messageCode
 
 void RemoteProcess::onConnectionError()
 {
+    if (m_state == Unconnected)
+        return;
+
     m_timerPing.stop();
     m_timerPongTimeout.stop();
+    m_timerConnectionTimeout.stop();
     m_state = Unconnected;
     emit connectionError();
 }
 
+void RemoteProcess::onProcessError(QProcess::ProcessError error)
+{
+    if (error == QProcess::FailedToStart) {
+        log( "Remote process: Failed to start new remote process!", LogError );
+        onConnectionError();
+    }
+}
+
+void RemoteProcess::onProcessFinished(int exitCode)
+{
+    COPYQ_LOG( QString("Remote process: Exited with code %1.").arg(exitCode) );
+    onConnectionError();
+}
+
+void RemoteProcess::stopProcess()
+{
+    if (m_process == NULL)
+        return;
+
+    m_process->disconnect(this);
+
+    if ( m_process->state() == QProcess::NotRunning ) {
+        // Process can be stopped from its own signal handler.
+        m_process->deleteLater();
+    } else {
+        // Process exits after connection is closed; kill it if it doesn't.
+        if (m_socket)
+            m_socket->close();
+
+        // Process outlives this object until it exits.
+        m_process->setParent( QCoreApplication::instance() );
+        connect( m_process, SIGNAL(finished(int)),
+                 m_process, SLOT(deleteLater()) );
+        QTimer::singleShot( exitTimeout, m_process, SLOT(kill()) );
+    }
+
+    m_process = NULL;
+}
+
+void RemoteProcess::setPingIntervals(int pingMs, int pongTimeoutMs)
+{
+    m_timerPing.setInterval(pingMs);
+    m_timerPongTimeout.setInterval(pongTimeoutMs);
+}
+
+Q_PID RemoteProcess::processId() const
+{
+    return m_process ? m_process->pid() : Q_PID();
+}
+
 void RemoteProcess::writeMessage(const QByteArray &msg, int messageCode)
 {
     emit sendMessage(msg, messageCode);
@@ -20,7 +20,10 @@
 #ifndef REMOTEPROCESS_H
 #define REMOTEPROCESS_H
 
+#include <QElapsedTimer>
 #include <QObject>
+#include <QPointer>
+#include <QProcess>
 #include <QTimer>
 
 class Arguments;
@@ -31,6 +34,10 @@ class QString;
 
 /**
  * Starts process and handles communication with it.
+ *
+ * Connection error is reported as soon as the process exits or closes
+ * connection. The process is pinged only after longer period of inactivity
+ * to find out if it's not stuck.
  */
 class RemoteProcess : public QObject
 {
@@ -45,6 +52,17 @@ public:
      */
     void start(const QString &newServerName, const QStringList &arguments);
 
+    /**
+     * Set interval of inactivity before pinging remote process and interval
+     * to wait for the response.
+     */
+    void setPingIntervals(int pingMs, int pongTimeoutMs);
+
+    /**
+     * Return ID of running remote process.
+     */
+    Q_PID processId() const;
+
     /**
      * Send message to remote process.
      */
@@ -83,10 +101,19 @@ private slots:
     void onMessageReceived(const QByteArray &message, int messageCode);
     bool checkConnection();
     void onConnectionError();
+    void onProcessError(QProcess::ProcessError error);
+    void onProcessFinished(int exitCode);
 
 private:
+    /// Close connection and let process exit; kill it later if it doesn't.
+    void stopProcess();
+
     QTimer m_timerPing;
     QTimer m_timerPongTimeout;
+    QTimer m_timerConnectionTimeout;
+    QElapsedTimer m_startTime;
+    QProcess *m_process;
+    QPointer<ClientSocket> m_socket;
     enum State {
         Unconnected,
         Connecting,
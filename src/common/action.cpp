@@ -19,39 +19,43 @@
 
 #include "action.h"
 
+#include "common/arguments.h"
+#include "common/clientsocket.h"
+#include "common/commandstatus.h"
+#include "common/coprocess.h"
 #include "common/mimetypes.h"
 #include "item/serialize.h"
 
 #include <QCoreApplication>
+#include <QDir>
 #include <QProcessEnvironment>
 #include <QPointer>
+#include <QTextCodec>
+#include <QThread>
 
 #include <string.h>
 
 namespace {
 
-void startProcess(QProcess *process, const QStringList &args)
-{
-    QString executable = args.value(0);
-
-    // Replace "copyq" command with full application path.
-    if (executable == "copyq")
-        executable = QCoreApplication::applicationFilePath();
+/**
+ * Separator is searched from this number of characters before end of text
+ * scanned previously so separators split between reads are found.
+ */
+const int separatorLookBehind = 64;
 
-    process->start(executable, args.mid(1), QIODevice::ReadWrite);
-}
+/// Input is written to process in chunks of this size as the pipe is drained.
+const int inputChunkSize = 64 * 1024;
 
-void startWritingInput(const QByteArray &input, QPointer<QProcess> p)
-{
-    if (!p)
-        return;
+/// Interval for sampling resources used by running processes.
+const int usageSampleIntervalMs = 250;
 
-    p->write(input);
-    p->closeWriteChannel();
+/// Terminated process is killed after this time.
+const int terminateTimeoutMs = 5000;
 
-    while ( p && !p->waitForBytesWritten(0) )
-        QCoreApplication::processEvents();
-}
+/// Environment for new processes is read only once (see Action::resetEnvironment()).
+QMutex environmentLock;
+QProcessEnvironment environment;
+bool environmentLoaded = false;
 
 template <typename Entry, typename Container>
 void appendAndClearNonEmpty(Entry &entry, Container &containter)
@@ -180,17 +184,99 @@ quintptr actionId(const Action *act)
 
 } // namespace
 
+/**
+ * Client for "copyq:" script evaluated in current process.
+ *
+ * Handles messages from script same way as client process would and passes
+ * output and exit code to action.
+ */
+class ActionScriptClient : public ClientSocket
+{
+public:
+    explicit ActionScriptClient(Action *action)
+        : ClientSocket()
+        , m_action(action)
+        , m_finished(false)
+    {
+        setConnected(true);
+    }
+
+    void start()
+    {
+        // Input is sent only if requested by script.
+    }
+
+    void sendMessage(const QByteArray &message, int messageCode)
+    {
+        if (m_finished || !m_action)
+            return;
+
+        if ( isClosed() ) {
+            // Ignore output of terminated script.
+        } else if (messageCode == CommandActivateWindow) {
+            // Window is already activated by server.
+        } else if (messageCode == CommandReadInput) {
+            m_action->m_usage.bytesIn += m_action->input().size();
+            emit messageReceived(m_action->input(), 0);
+        } else if (messageCode == CommandSuccess || messageCode == CommandFinished) {
+            m_action->appendOutput(message);
+        } else {
+            m_action->appendErrorOutput(message);
+        }
+
+        if (messageCode == CommandFinished || messageCode == CommandBadSyntax || messageCode == CommandError)
+            finish(messageCode);
+    }
+
+    void deleteAfterDisconnected()
+    {
+        // Script can end without exit code (e.g. if client is closed before it starts).
+        finish(CommandError);
+        deleteLater();
+    }
+
+    void close()
+    {
+        setConnected(false);
+    }
+
+    bool isFinished() const { return m_finished; }
+
+private:
+    void finish(int exitCode)
+    {
+        if (m_finished)
+            return;
+
+        m_finished = true;
+        if (m_action)
+            m_action->scriptFinished(exitCode);
+    }
+
+    QPointer<Action> m_action;
+    bool m_finished;
+};
+
 QMutex Action::actionsLock;
 QVector<Action*> Action::actions;
+ActionScriptRunner *Action::scriptRunner = NULL;
 
 Action::Action(QObject *parent)
     : QObject(parent)
+    , m_inputWritten(0)
+    , m_outputScanned(0)
     , m_failed(false)
     , m_currentLine(-1)
+    , m_coprocess(false)
+    , m_hasArguments(false)
     , m_exitCode(0)
 {
     setProperty("COPYQ_ACTION_ID", actionId(this));
 
+    m_wallTime.invalidate();
+    m_usageTimer.setInterval(usageSampleIntervalMs);
+    connect( &m_usageTimer, SIGNAL(timeout()), this, SLOT(sampleUsage()) );
+
     const QMutexLocker lock(&actionsLock);
     actions.append(this);
 }
@@ -222,10 +308,14 @@ QString Action::command() const
 void Action::setCommand(const QString &command, const QStringList &arguments)
 {
     m_cmds = parseCommands(command, arguments);
+    m_commandName = command;
+    m_hasArguments = command.contains( QRegExp("(^|[^\\\\])%[1-9]") );
 }
 
 void Action::setCommand(const QStringList &arguments)
 {
+    m_hasArguments = false;
+    m_commandName = arguments.value(0);
     m_cmds.clear();
     m_cmds.append(QList<QStringList>() << arguments);
 }
@@ -246,21 +336,39 @@ void Action::start()
     closeSubCommands();
 
     if ( m_currentLine + 1 >= m_cmds.size() ) {
-        emit actionFinished(this);
+        finish();
         return;
     }
 
+    if (m_currentLine == -1) {
+        m_wallTime.start();
+        m_usageTimer.start();
+    }
+
     ++m_currentLine;
     const QList<QStringList> &cmds = m_cmds[m_currentLine];
 
     Q_ASSERT( !cmds.isEmpty() );
 
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    env.insert("COPYQ_ACTION_ID", QString::number(actionId(this)));
+    if ( canRunScript(cmds) ) {
+        runScript(cmds.first());
+        return;
+    }
+
+    if ( canRunCoprocess(cmds) ) {
+        runCoprocess(cmds.first());
+        return;
+    }
+
+    // Environment is shared by processes on all command lines.
+    if ( m_environment.isEmpty() ) {
+        m_environment = processEnvironment();
+        m_environment.insert("COPYQ_ACTION_ID", QString::number(actionId(this)));
+    }
 
     for (int i = 0; i < cmds.size(); ++i) {
         m_processes.append(new QProcess(this));
-        m_processes.last()->setProcessEnvironment(env);
+        m_processes.last()->setProcessEnvironment(m_environment);
 
         connect( m_processes.last(), SIGNAL(error(QProcess::ProcessError)),
                  SLOT(actionError(QProcess::ProcessError)) );
@@ -280,6 +388,9 @@ void Action::start()
              this, SLOT(actionFinished()) );
     connect( m_processes.last(), SIGNAL(readyReadStandardOutput()),
              this, SLOT(actionOutput()) );
+    // Sample short-lived processes once before they exit (otherwise only periodically).
+    connect( m_processes.last(), SIGNAL(readChannelFinished()),
+             this, SLOT(sampleUsage()) );
 
     // Writing directly to stdin of a process on Windows can hang the app.
     connect( m_processes.first(), SIGNAL(started()),
@@ -294,16 +405,28 @@ void Action::start()
 
 bool Action::waitForStarted(int msecs)
 {
+    if (m_scriptClient || m_runningCoprocess)
+        return true;
+
     return !m_processes.isEmpty() && m_processes.last()->waitForStarted(msecs);
 }
 
 bool Action::waitForFinished(int msecs)
 {
+    if (m_scriptClient || m_runningCoprocess)
+        return !isRunning();
+
     return m_processes.isEmpty() || m_processes.last()->waitForFinished(msecs);
 }
 
 bool Action::isRunning() const
 {
+    if (m_scriptClient)
+        return !m_scriptClient->isFinished();
+
+    if (m_runningCoprocess)
+        return true;
+
     return !m_processes.isEmpty() && m_processes.last()->state() != QProcess::NotRunning;
 }
 
@@ -319,6 +442,39 @@ QVariantMap Action::data(quintptr id)
     return i != -1 ? actions[i]->m_data : QVariantMap();
 }
 
+void Action::startProcess(QProcess *process, const QStringList &args)
+{
+    QString executable = args.value(0);
+
+    // Replace "copyq" command with full application path.
+    if (executable == "copyq")
+        executable = QCoreApplication::applicationFilePath();
+
+    process->start(executable, args.mid(1), QIODevice::ReadWrite);
+}
+
+QProcessEnvironment Action::processEnvironment()
+{
+    const QMutexLocker lock(&environmentLock);
+    if (!environmentLoaded) {
+        environment = QProcessEnvironment::systemEnvironment();
+        environmentLoaded = true;
+    }
+    return environment;
+}
+
+void Action::resetEnvironment()
+{
+    const QMutexLocker lock(&environmentLock);
+    environmentLoaded = false;
+    environment = QProcessEnvironment();
+}
+
+void Action::setScriptRunner(ActionScriptRunner *runner)
+{
+    scriptRunner = runner;
+}
+
 void Action::actionError(QProcess::ProcessError)
 {
     QProcess *p = qobject_cast<QProcess*>(sender());
@@ -331,7 +487,7 @@ void Action::actionError(QProcess::ProcessError)
 
     if ( !isRunning() ) {
         closeSubCommands();
-        emit actionFinished(this);
+        finish();
     }
 }
 
@@ -343,9 +499,21 @@ void Action::actionStarted()
 
 void Action::actionFinished()
 {
+    // Other processes in pipeline can still be running.
+    sampleUsage();
     actionOutput();
+    lineFinished();
+}
 
+void Action::lineFinished()
+{
     if (hasTextOutput()) {
+        if ( !m_sep.isEmpty() ) {
+            // Separator at the end of output was not handled yet.
+            splitOutput(true);
+            m_outputScanned = 0;
+        }
+
         if (canEmitNewItems()) {
             m_items.append(m_lastOutput);
             if (m_index.isValid())
@@ -371,38 +539,107 @@ void Action::actionOutput()
     QProcess *p = qobject_cast<QProcess*>(sender());
     Q_ASSERT(p);
 
-    const QByteArray output = p->readAll();
+    appendOutput( p->readAll() );
+}
+
+void Action::appendOutput(const QByteArray &output)
+{
+    m_usage.bytesOut += output.size();
 
     if (hasTextOutput()) {
-        m_lastOutput.append( QString::fromUtf8(output) );
-        if ( !m_lastOutput.isEmpty() && !m_sep.isEmpty() ) {
-            // Split to items.
-            QStringList items;
-            items = m_lastOutput.split(m_sep);
-            m_lastOutput = items.takeLast();
-            if (m_index.isValid()) {
-                emit newItems(items, m_index);
-            } else if (!m_tab.isEmpty()) {
-                emit newItems(items, m_tab);
-            }
-        }
+        // Decoder keeps incomplete UTF-8 sequences for next output.
+        if (m_outputDecoder.isNull())
+            m_outputDecoder.reset( QTextCodec::codecForName("UTF-8")->makeDecoder() );
+        m_lastOutput.append( m_outputDecoder->toUnicode(output) );
+        if ( !m_lastOutput.isEmpty() && !m_sep.isEmpty() )
+            splitOutput(false);
     } else if (!m_outputFormat.isEmpty()) {
         m_outputData.append(output);
     }
 }
 
+void Action::appendErrorOutput(const QByteArray &errorOutput)
+{
+    m_errstr.append( QString::fromUtf8(errorOutput) );
+}
+
+void Action::splitOutput(bool outputFinished)
+{
+    QStringList items;
+    int itemStart = 0;
+    int searchStart = m_outputScanned;
+    int i = m_sep.indexIn(m_lastOutput, searchStart);
+
+    // Separator matching the end of output can be longer after next read.
+    while ( i != -1 && (outputFinished || i + m_sep.matchedLength() < m_lastOutput.size()) ) {
+        items.append( m_lastOutput.mid(itemStart, i - itemStart) );
+        itemStart = i + m_sep.matchedLength();
+        // Skip empty match (same as QString::split()).
+        searchStart = m_sep.matchedLength() == 0 ? itemStart + 1 : itemStart;
+        i = m_sep.indexIn(m_lastOutput, searchStart);
+    }
+
+    m_lastOutput.remove(0, itemStart);
+
+    // Next search starts only shortly before new output.
+    if (i == -1)
+        m_outputScanned = qMax(searchStart - itemStart, m_lastOutput.size() - separatorLookBehind);
+    else
+        m_outputScanned = i - itemStart;
+
+    if ( !items.isEmpty() )
+        emitNewItems(items);
+}
+
+void Action::emitNewItems(const QStringList &items)
+{
+    if (m_index.isValid()) {
+        emit newItems(items, m_index);
+    } else if (!m_tab.isEmpty()) {
+        emit newItems(items, m_tab);
+    }
+}
+
 void Action::actionErrorOutput()
 {
     QProcess *p = qobject_cast<QProcess*>(sender());
     Q_ASSERT(p);
 
-    m_errstr.append( QString::fromUtf8(p->readAllStandardError()) );
+    appendErrorOutput( p->readAllStandardError() );
 }
 
 void Action::writeInput()
 {
-    if (m_processes.value(0) == sender())
-        startWritingInput(m_input, m_processes.value(0));
+    QProcess *p = m_processes.value(0);
+    if (p != sender())
+        return;
+
+    m_inputWritten = 0;
+    connect( p, SIGNAL(bytesWritten(qint64)),
+             this, SLOT(onInputBytesWritten()) );
+    writeInputChunk(p);
+}
+
+void Action::onInputBytesWritten()
+{
+    QProcess *p = m_processes.value(0);
+    if (p == sender() && p->bytesToWrite() == 0 && m_inputWritten < m_input.size())
+        writeInputChunk(p);
+}
+
+void Action::writeInputChunk(QProcess *p)
+{
+    const int size = qMin(inputChunkSize, m_input.size() - m_inputWritten);
+
+    // Process buffers only the current chunk (a copy, so it can outlive this action).
+    if (size > 0) {
+        p->write( m_input.mid(m_inputWritten, size) );
+        m_inputWritten += size;
+        m_usage.bytesIn += size;
+    }
+
+    if ( m_inputWritten >= m_input.size() )
+        p->closeWriteChannel();
 }
 
 bool Action::hasTextOutput() const
@@ -412,6 +649,18 @@ bool Action::hasTextOutput() const
 
 void Action::terminate()
 {
+    if (m_scriptClient) {
+        m_failed = true;
+        m_scriptClient->close();
+        return;
+    }
+
+    if (m_runningCoprocess) {
+        m_runningCoprocess->cancel(this);
+        coprocessFinished( QByteArray(), tr("Terminated") );
+        return;
+    }
+
     if (m_processes.isEmpty())
         return;
 
@@ -420,8 +669,20 @@ void Action::terminate()
         p->terminate();
 
     // if process still running: kill it
-    if ( !m_processes.last()->waitForFinished(5000) )
-        m_processes.last()->kill();
+    QTimer::singleShot(terminateTimeoutMs, this, SLOT(kill()));
+}
+
+void Action::kill()
+{
+    if (m_scriptClient || m_runningCoprocess) {
+        terminate();
+        return;
+    }
+
+    foreach (QProcess *p, m_processes) {
+        if ( p->state() != QProcess::NotRunning )
+            p->kill();
+    }
 }
 
 bool Action::canEmitNewItems() const
@@ -431,8 +692,40 @@ bool Action::canEmitNewItems() const
                  || (m_outputFormat == mimeText && !m_lastOutput.isEmpty()) );
 }
 
+void Action::sampleUsage()
+{
+    m_usageSampler.sample(m_processes);
+}
+
+void Action::finish()
+{
+    m_usageTimer.stop();
+
+    if ( m_wallTime.isValid() )
+        m_usage.wallTimeMs = m_wallTime.elapsed();
+    m_usage.cpuTimeMs = m_usageSampler.cpuTimeMs();
+    m_usage.peakMemoryKb = m_usageSampler.peakMemoryKb();
+
+    // Expanded arguments can contain item data so don't use command().
+    ActionStatistics::record( m_name.isEmpty() ? m_commandName : m_name, m_usage, m_failed );
+
+    emit actionFinished(this);
+}
+
 void Action::closeSubCommands()
 {
+    if (m_scriptClient) {
+        // Abort script if it's still running.
+        if ( !m_scriptClient->isFinished() )
+            m_scriptClient->close();
+        m_scriptClient = NULL;
+    }
+
+    if (m_runningCoprocess) {
+        m_runningCoprocess->cancel(this);
+        m_runningCoprocess = NULL;
+    }
+
     if (m_processes.isEmpty())
         return;
 
@@ -444,3 +737,85 @@ void Action::closeSubCommands()
 
     m_processes.clear();
 }
+
+bool Action::canRunScript(const QList<QStringList> &cmds) const
+{
+    // Scripts can be evaluated in the same process only if the result is
+    // handled in main thread (blocking calls to main thread would deadlock).
+    if ( scriptRunner == NULL || thread() != QCoreApplication::instance()->thread() )
+        return false;
+
+    if ( cmds.size() != 1 )
+        return false;
+
+    const QStringList &cmd = cmds.first();
+    return cmd.size() >= 4 && cmd[0] == "copyq" && cmd[1] == "eval" && cmd[2] == "--";
+}
+
+void Action::runScript(const QStringList &cmd)
+{
+    // Same arguments as client process would send ("--" is omitted).
+    Arguments args;
+    args.removeAllArguments();
+    args.append( QDir::currentPath().toUtf8() );
+    args.append( QByteArray::number(actionId(this)) );
+    args.append( QByteArray() ); // commands are grouped by action ID
+    args.append("eval");
+    for (int i = 3; i < cmd.size(); ++i)
+        args.append( cmd[i].toUtf8() );
+
+    ActionScriptClient *client = new ActionScriptClient(this);
+    m_scriptClient = client;
+
+    if (m_currentLine == 0)
+        emit actionStarted(this);
+
+    // Script can finish (and start next line) immediately.
+    scriptRunner->runScript(args, client);
+}
+
+void Action::scriptFinished(int exitCode)
+{
+    m_exitCode = exitCode;
+    lineFinished();
+}
+
+bool Action::canRunCoprocess(const QList<QStringList> &cmds) const
+{
+    // Coprocesses are shared only by actions in main thread and only if
+    // command line doesn't change with arguments (otherwise there could be
+    // a program running for each different argument).
+    return m_coprocess && !m_hasArguments
+            && m_cmds.size() == 1 && cmds.size() == 1
+            && thread() == QCoreApplication::instance()->thread();
+}
+
+void Action::runCoprocess(const QStringList &cmd)
+{
+    Coprocess *coprocess = Coprocess::instance(cmd);
+    m_runningCoprocess = coprocess;
+
+    if (m_currentLine == 0)
+        emit actionStarted(this);
+
+    // Request can fail (and start next line) immediately.
+    m_usage.bytesIn += m_input.size();
+    coprocess->request(this, m_input);
+}
+
+void Action::coprocessFinished(const QByteArray &output, const QString &error)
+{
+    m_runningCoprocess = NULL;
+
+    if ( error.isEmpty() ) {
+        appendOutput(output);
+        m_exitCode = 0;
+    } else {
+        if (!m_errorString.isEmpty())
+            m_errorString.append("\n");
+        m_errorString.append(error);
+        m_failed = true;
+    }
+
+    lineFinished();
+}
@@ -20,21 +20,47 @@
 #ifndef ACTION_H
 #define ACTION_H
 
+#include "common/actionstatistics.h"
+
+#include <QElapsedTimer>
 #include <QModelIndex>
 #include <QMutex>
+#include <QPointer>
+#include <QProcessEnvironment>
 #include <QProcess>
+#include <QScopedPointer>
 #include <QStringList>
+#include <QTextDecoder>
+#include <QTimer>
 #include <QVariantMap>
 #include <QVector>
 
+class ActionScriptClient;
+class Arguments;
+class ClientSocket;
+class Coprocess;
 class QAction;
 
+/**
+ * Evaluates "copyq:" scripts of actions in current process.
+ */
+class ActionScriptRunner
+{
+public:
+    virtual ~ActionScriptRunner() {}
+
+    /// Run client command; messages for client are sent to @a client.
+    virtual void runScript(const Arguments &args, ClientSocket *client) = 0;
+};
+
 /**
  * Execute external program.
  */
 class Action : public QObject
 {
     Q_OBJECT
+    friend class ActionScriptClient;
+    friend class Coprocess;
 public:
     /** Create action with command line parameters. */
     explicit Action(QObject *parent = NULL);
@@ -77,6 +103,13 @@ public:
     QString outputTab() const { return m_tab; }
     void setOutputTab(const QString &outputTabName) { m_tab = outputTabName; }
 
+    /**
+     * Pass input to long-running program instead of starting it each time (see Coprocess).
+     *
+     * Ignored if command contains arguments %1..%9 (program would differ for each action).
+     */
+    void setCoprocess(bool coprocess) { m_coprocess = coprocess; }
+
     /** Return destination index. */
     QModelIndex index() const { return m_index; }
     void setIndex(const QModelIndex &index) { m_index = index; }
@@ -84,8 +117,13 @@ public:
     /** Execute command. */
     void start();
 
+    /**
+     * Wait for program to start or finish.
+     *
+     * Commands evaluated in main thread (scripts and coprocess requests) are
+     * not waited for, use actionFinished() signal instead.
+     */
     bool waitForStarted(int msecs);
-
     bool waitForFinished(int msecs);
 
     bool isRunning() const;
@@ -103,12 +141,38 @@ public:
 
     void setData(const QVariantMap &data);
 
+    /// Return resources used by finished action.
+    const ActionUsage &usage() const { return m_usage; }
+
     static QVariantMap data(quintptr id);
 
+    /**
+     * Set object which evaluates "copyq:" scripts instead of starting new process.
+     *
+     * Only actions in main thread use it. Set to NULL to disable.
+     */
+    static void setScriptRunner(ActionScriptRunner *runner);
+
+    /**
+     * Start process with arguments same way as commands are started.
+     *
+     * Command "copyq" is replaced with path to this application.
+     */
+    static void startProcess(QProcess *process, const QStringList &args);
+
+    /// Return environment for new processes.
+    static QProcessEnvironment processEnvironment();
+
+    /// Reload environment for new processes (call after environment changes).
+    static void resetEnvironment();
+
 public slots:
-    /** Terminate (kill) process. */
+    /** Terminate process and kill it if it doesn't exit in time (doesn't block). */
     void terminate();
 
+    /** Kill process. */
+    void kill();
+
 signals:
     /** Emitted on error. */
     void actionError(Action *act);
@@ -132,25 +196,70 @@ private slots:
     void actionOutput();
     void actionErrorOutput();
     void writeInput();
+    void onInputBytesWritten();
+    void sampleUsage();
 
 private:
     static QMutex actionsLock;
     static QVector<Action*> actions;
+    static ActionScriptRunner *scriptRunner;
 
     bool hasTextOutput() const;
     bool canEmitNewItems() const;
 
     void closeSubCommands();
 
+    /// Record resource usage and emit actionFinished().
+    void finish();
+
+    /// Emit remaining output and start next command line.
+    void lineFinished();
+
+    void appendOutput(const QByteArray &output);
+
+    void appendErrorOutput(const QByteArray &errorOutput);
+
+    /**
+     * Emit items from text output scanning only text not searched previously.
+     *
+     * Separator at the end of output is handled only if @a outputFinished is true.
+     */
+    void splitOutput(bool outputFinished);
+
+    void emitNewItems(const QStringList &items);
+
+    /// Write next part of input to process (closes input after last part).
+    void writeInputChunk(QProcess *p);
+
+    /// Return true if command line can be evaluated by script runner.
+    bool canRunScript(const QList<QStringList> &cmds) const;
+
+    void runScript(const QStringList &cmd);
+
+    /// Called by ActionScriptClient when script finishes.
+    void scriptFinished(int exitCode);
+
+    /// Return true if command line can be passed to Coprocess.
+    bool canRunCoprocess(const QList<QStringList> &cmds) const;
+
+    void runCoprocess(const QStringList &cmd);
+
+    /// Called by Coprocess with output record or error.
+    void coprocessFinished(const QByteArray &output, const QString &error);
+
     QByteArray m_input;
+    int m_inputWritten; ///< Size of input already passed to first process.
     QRegExp m_sep;
     QList< QList<QStringList> > m_cmds;
+    QString m_commandName; ///< Command without expanded arguments (for statistics).
     QString m_tab;
     QStringList m_inputFormats;
     QString m_outputFormat;
     QPersistentModelIndex m_index;
     QString m_errstr;
     QString m_lastOutput;
+    int m_outputScanned; ///< Position in m_lastOutput to search separator from.
+    QScopedPointer<QTextDecoder> m_outputDecoder;
     QByteArray m_outputData;
     bool m_failed;
     int m_currentLine;
@@ -158,9 +267,20 @@ private:
     QStringList m_items;
     QVariantMap m_data;
     QVector<QProcess*> m_processes;
+    QPointer<ActionScriptClient> m_scriptClient;
+    bool m_coprocess;
+    bool m_hasArguments; ///< Command contains %1..%9.
+    QPointer<Coprocess> m_runningCoprocess;
 
     int m_exitCode;
     QString m_errorString;
+
+    QProcessEnvironment m_environment;
+
+    ActionUsage m_usage;
+    ProcessUsageSampler m_usageSampler;
+    QElapsedTimer m_wallTime;
+    QTimer m_usageTimer;
 };
 
 #endif // ACTION_H
@@ -0,0 +1,225 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "actionstatistics.h"
+
+#include "common/log.h"
+
+#include <QFile>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QProcess>
+#include <QStringList>
+
+#ifdef Q_OS_LINUX
+#   include <unistd.h>
+#endif
+
+namespace {
+
+/// Actions running longer are flagged as slow.
+const qint64 slowActionMs = 1000;
+
+/// Number of last runs kept for each command name.
+const int historySize = 20;
+
+/// Maximum number of command names in history (least recently used are removed).
+const int maxHistoryNames = 200;
+
+struct ActionRun {
+    ActionUsage usage;
+    bool failed;
+};
+
+QMutex historyLock;
+QMap< QString, QList<ActionRun> > history;
+QStringList historyOrder; ///< Command names, least recently used first.
+
+#ifdef Q_OS_LINUX
+QByteArray readProcFile(qint64 pid, const char *name)
+{
+    QFile file( QString("/proc/%1/%2").arg(pid).arg(name) );
+    if ( !file.open(QIODevice::ReadOnly) )
+        return QByteArray();
+    return file.readAll();
+}
+
+/// Return user and system time in clock ticks or -1 on error.
+qint64 readCpuTicks(qint64 pid)
+{
+    // Fields after command name (which can contain spaces) start with process state.
+    const QByteArray stat = readProcFile(pid, "stat");
+    const int i = stat.lastIndexOf(')');
+    if (i == -1)
+        return -1;
+
+    const QList<QByteArray> fields = stat.mid(i + 2).split(' ');
+    if (fields.size() < 13)
+        return -1;
+
+    return fields[11].toLongLong() + fields[12].toLongLong();
+}
+
+/// Return peak resident memory in kB or -1 on error.
+qint64 readPeakMemoryKb(qint64 pid)
+{
+    const QByteArray status = readProcFile(pid, "status");
+    const QByteArray key = "VmHWM:";
+    const int i = status.indexOf(key);
+    if (i == -1)
+        return -1;
+
+    const int end = status.indexOf('\n', i);
+    const QByteArray value = status.mid(i + key.size(), end - i - key.size());
+    return value.simplified().split(' ').value(0).toLongLong();
+}
+#endif
+
+} // namespace
+
+void ProcessUsageSampler::sample(const QVector<QProcess*> &processes)
+{
+#ifdef Q_OS_LINUX
+    foreach (QProcess *process, processes) {
+        const qint64 pid = process->pid();
+        if (pid <= 0)
+            continue;
+
+        const qint64 cpuTicks = readCpuTicks(pid);
+        const qint64 peakMemoryKb = readPeakMemoryKb(pid);
+        if (cpuTicks < 0 || peakMemoryKb < 0)
+            continue;
+
+        ProcessUsage &usage = m_processes[pid];
+        usage.cpuTicks = cpuTicks;
+        usage.peakMemoryKb = peakMemoryKb;
+    }
+#else
+    Q_UNUSED(processes);
+#endif
+}
+
+qint64 ProcessUsageSampler::cpuTimeMs() const
+{
+#ifdef Q_OS_LINUX
+    qint64 ticks = 0;
+    foreach (const ProcessUsage &usage, m_processes)
+        ticks += usage.cpuTicks;
+
+    const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    return ticksPerSecond > 0 ? ticks * 1000 / ticksPerSecond : 0;
+#else
+    return 0;
+#endif
+}
+
+qint64 ProcessUsageSampler::peakMemoryKb() const
+{
+    qint64 memoryKb = 0;
+    foreach (const ProcessUsage &usage, m_processes)
+        memoryKb += usage.peakMemoryKb;
+    return memoryKb;
+}
+
+void ActionStatistics::record(const QString &name, const ActionUsage &usage, bool failed)
+{
+    // Command can span multiple lines.
+    const QString key = name.simplified();
+
+    if ( isSlow(usage) )
+        COPYQ_LOG( QString("Slow command (%1 ms): %2").arg(usage.wallTimeMs).arg(key) );
+
+    const QMutexLocker lock(&historyLock);
+
+    if ( history.contains(key) ) {
+        historyOrder.removeOne(key);
+    } else if ( history.size() >= maxHistoryNames ) {
+        history.remove( historyOrder.takeFirst() );
+    }
+    historyOrder.append(key);
+
+    QList<ActionRun> &runs = history[key];
+    const ActionRun run = { usage, failed };
+    runs.append(run);
+    if (runs.size() > historySize)
+        runs.removeFirst();
+}
+
+bool ActionStatistics::isSlow(const ActionUsage &usage)
+{
+    return usage.wallTimeMs >= slowActionMs;
+}
+
+QString ActionStatistics::statistics()
+{
+    QString result = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+            .arg("runs", 4)
+            .arg("failed", 6)
+            .arg("slow", 4)
+            .arg("wall_ms(avg/max)", 16)
+            .arg("cpu_ms(avg)", 11)
+            .arg("peak_kb(max)", 12)
+            .arg("in_bytes(avg)", 13)
+            .arg("out_bytes(avg)", 14)
+            .arg("command");
+
+    const QMutexLocker lock(&historyLock);
+
+    for ( QMap< QString, QList<ActionRun> >::const_iterator it = history.constBegin();
+          it != history.constEnd(); ++it )
+    {
+        const QList<ActionRun> &runs = it.value();
+        int failed = 0;
+        int slow = 0;
+        qint64 totalWallMs = 0;
+        qint64 maxWallMs = 0;
+        qint64 totalCpuMs = 0;
+        qint64 maxMemoryKb = 0;
+        qint64 totalBytesIn = 0;
+        qint64 totalBytesOut = 0;
+
+        foreach (const ActionRun &run, runs) {
+            if (run.failed)
+                ++failed;
+            if ( isSlow(run.usage) )
+                ++slow;
+            totalWallMs += run.usage.wallTimeMs;
+            maxWallMs = qMax(maxWallMs, run.usage.wallTimeMs);
+            totalCpuMs += run.usage.cpuTimeMs;
+            maxMemoryKb = qMax(maxMemoryKb, run.usage.peakMemoryKb);
+            totalBytesIn += run.usage.bytesIn;
+            totalBytesOut += run.usage.bytesOut;
+        }
+
+        const int count = runs.size();
+        result.append( QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+                       .arg(count, 4)
+                       .arg(failed, 6)
+                       .arg(slow, 4)
+                       .arg(QString::number(totalWallMs / count) + "/" + QString::number(maxWallMs), 16)
+                       .arg(totalCpuMs / count, 11)
+                       .arg(maxMemoryKb, 12)
+                       .arg(totalBytesIn / count, 13)
+                       .arg(totalBytesOut / count, 14)
+                       .arg(it.key()) );
+    }
+
+    return result;
+}
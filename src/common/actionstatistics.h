@@ -0,0 +1,92 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ACTIONSTATISTICS_H
+#define ACTIONSTATISTICS_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+class QProcess;
+
+/**
+ * Resources used by an action.
+ */
+struct ActionUsage {
+    ActionUsage()
+        : wallTimeMs(0)
+        , cpuTimeMs(0)
+        , peakMemoryKb(0)
+        , bytesIn(0)
+        , bytesOut(0)
+    {}
+
+    qint64 wallTimeMs;
+    qint64 cpuTimeMs; ///< User and system time of child processes (sampled, Linux only).
+    qint64 peakMemoryKb; ///< Sum of peak resident memory of child processes (sampled, Linux only).
+    qint64 bytesIn; ///< Input passed to command.
+    qint64 bytesOut; ///< Output read from command.
+};
+
+/**
+ * Samples CPU time and peak memory of running processes.
+ *
+ * Values are read from /proc on Linux; elsewhere nothing is sampled.
+ */
+class ProcessUsageSampler
+{
+public:
+    void sample(const QVector<QProcess*> &processes);
+
+    qint64 cpuTimeMs() const;
+
+    qint64 peakMemoryKb() const;
+
+private:
+    struct ProcessUsage {
+        qint64 cpuTicks;
+        qint64 peakMemoryKb;
+    };
+
+    QHash<qint64, ProcessUsage> m_processes;
+};
+
+/**
+ * Rolling history of resources used by actions for each command name.
+ *
+ * Names shouldn't contain item data (commands are recorded before expanding
+ * arguments). Least recently used names are removed if there are too many.
+ *
+ * All methods are thread-safe.
+ */
+class ActionStatistics
+{
+public:
+    /// Add finished action to history.
+    static void record(const QString &name, const ActionUsage &usage, bool failed);
+
+    /// Return true if action took too long (is flagged as slow).
+    static bool isSlow(const ActionUsage &usage);
+
+    /// Return statistics for each command name as text.
+    static QString statistics();
+};
+
+#endif // ACTIONSTATISTICS_H
@@ -24,6 +24,10 @@
 #include <QFile>
 #include <QDir>
 
+#ifdef Q_OS_UNIX
+#   include <unistd.h>
+#endif
+
 namespace {
 
 QString parseCommandLineArgument(const QString &arg)
@@ -101,6 +105,9 @@ void Arguments::reset()
     m_args.resize(Rest);
     m_args[CurrentPath] = QDir::currentPath().toUtf8();
     m_args[ActionId] = qgetenv("COPYQ_ACTION_ID");
+#ifdef Q_OS_UNIX
+    m_args[ParentProcessId] = QByteArray::number( static_cast<qint64>(getppid()) );
+#endif
 }
 
 void Arguments::append(const QByteArray &argument)
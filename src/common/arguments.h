@@ -37,6 +37,8 @@ public:
     enum {
         CurrentPath,
         ActionId,
+        /// ID of process which started client (empty if not available).
+        ParentProcessId,
         Rest
     };
 
@@ -45,7 +47,7 @@ public:
 
     ~Arguments();
 
-    /** Clear arguments and set current path and action id. */
+    /** Clear arguments and set current path, action id and parent process id. */
     void reset();
 
     /** Append argument. */
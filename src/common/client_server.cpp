@@ -19,10 +19,34 @@
 
 #include "common/client_server.h"
 
+#include "common/log.h"
+
 #include <QCoreApplication>
+#include <QDataStream>
+#include <QLocalSocket>
 #include <QString>
 #include <QtGlobal>
 
+namespace {
+
+/// Reject messages with bigger length (possibly corrupted or malicious header).
+const quint32 maxMessageSize = 1024 * 1024 * 1024;
+
+bool readBytes(QLocalSocket *socket, qint64 size, QByteArray *bytes, int timeoutMs)
+{
+    bytes->clear();
+
+    while (bytes->size() < size) {
+        if ( socket->bytesAvailable() == 0 && !socket->waitForReadyRead(timeoutMs) )
+            return false;
+        bytes->append( socket->read(size - bytes->size()) );
+    }
+
+    return true;
+}
+
+} // namespace
+
 QString serverName(const QString &name)
 {
     // applicationName changes case depending on whether this is a GUI app
@@ -40,3 +64,67 @@ QString clipboardServerName()
 {
     return serverName("s");
 }
+
+bool readMessage(QLocalSocket *socket, QByteArray *msg, int waitForMessageMs)
+{
+    QByteArray bytes;
+    quint32 len;
+
+    COPYQ_LOG_VERBOSE("Reading message.");
+
+    if ( readBytes(socket, sizeof(len), &bytes, waitForMessageMs) ) {
+        QDataStream(bytes) >> len;
+
+        if (len > maxMessageSize) {
+            COPYQ_LOG( QString("ERROR: Message too big (%1 bytes)!").arg(len) );
+            return false;
+        }
+
+        if ( readBytes(socket, len, msg, socketTimeoutMs) ) {
+            COPYQ_LOG_VERBOSE( QString("Message read (%1 bytes).").arg(msg->size()) );
+            return true;
+        }
+    }
+
+    COPYQ_LOG("ERROR: Incorrect message!");
+
+    return false;
+}
+
+bool writeMessage(QLocalSocket *socket, const QByteArray &msg)
+{
+    COPYQ_LOG_VERBOSE( QString("Write message (%1 bytes).").arg(msg.size()) );
+
+    QDataStream out(socket);
+    // length is serialized as a quint32, followed by msg
+    out.writeBytes( msg.constData(), msg.length() );
+
+    if (out.status() != QDataStream::Ok) {
+        COPYQ_LOG("Cannot write message!");
+        return false;
+    }
+
+    COPYQ_LOG_VERBOSE("Message written.");
+    return true;
+}
+
+QByteArray createMessage(const QByteArray &data, int messageCode)
+{
+    QByteArray msg;
+    QDataStream out(&msg, QIODevice::WriteOnly);
+    out << static_cast<qint32>(messageCode);
+    out.writeRawData( data.constData(), data.length() );
+    return msg;
+}
+
+bool parseMessage(const QByteArray &msg, QByteArray *data, int *messageCode)
+{
+    qint32 code;
+    if ( msg.size() < static_cast<int>(sizeof(code)) )
+        return false;
+
+    QDataStream(msg) >> code;
+    *messageCode = code;
+    *data = msg.mid( sizeof(code) );
+    return true;
+}
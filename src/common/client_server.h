@@ -20,9 +20,33 @@
 #ifndef CLIENT_SERVER_H
 #define CLIENT_SERVER_H
 
+#include <QtGlobal>
+
+class QByteArray;
+class QLocalSocket;
 class QString;
 
+/// Interval to wait (in ms) for rest of a started message.
+const int socketTimeoutMs = 4000;
+
 QString serverName(const QString &name);
 QString clipboardServerName();
 
+/**
+ * Read message (length followed by data) from socket.
+ *
+ * Waits at most @a waitForMessageMs for start of the message (-1 to wait
+ * indefinitely) and at most socketTimeoutMs for each of its following parts.
+ */
+bool readMessage(QLocalSocket *socket, QByteArray *msg, int waitForMessageMs = socketTimeoutMs);
+
+/// Write message to socket (length followed by data).
+bool writeMessage(QLocalSocket *socket, const QByteArray &msg);
+
+/// Return message data prefixed with message code.
+QByteArray createMessage(const QByteArray &data, int messageCode);
+
+/// Split message to code and data.
+bool parseMessage(const QByteArray &msg, QByteArray *data, int *messageCode);
+
 #endif // CLIENT_SERVER_H
@@ -28,63 +28,6 @@
 #define SOCKET_LOG(text) \
     COPYQ_LOG_VERBOSE( QString("Socket %1: %2").arg(property("id").toInt()).arg(text) )
 
-namespace {
-
-bool readBytes(QLocalSocket *socket, qint64 size, QByteArray *bytes)
-{
-    qint64 avail, read = 0;
-    bytes->clear();
-    while (read < size) {
-        if ( socket->bytesAvailable() == 0 && !socket->waitForReadyRead(4000) )
-            return false;
-        avail = qMin( socket->bytesAvailable(), size-read );
-        bytes->append( socket->read(avail) );
-        read += avail;
-    }
-
-    return true;
-}
-
-bool readMessage(QLocalSocket *socket, QByteArray *msg)
-{
-    QByteArray bytes;
-    quint32 len;
-
-    COPYQ_LOG_VERBOSE("Reading message.");
-
-    if ( readBytes(socket, sizeof(len), &bytes) ) {
-        QDataStream(bytes) >> len;
-
-        if ( readBytes(socket, len, msg) ) {
-            COPYQ_LOG_VERBOSE( QString("Message read (%1 bytes).").arg(msg->size()) );
-            return true;
-        }
-    }
-
-    COPYQ_LOG("ERROR: Incorrect message!");
-
-    return false;
-}
-
-bool writeMessage(QLocalSocket *socket, const QByteArray &msg)
-{
-    COPYQ_LOG_VERBOSE( QString("Write message (%1 bytes).").arg(msg.size()) );
-
-    QDataStream out(socket);
-    // length is serialized as a quint32, followed by msg
-    out.writeBytes( msg.constData(), msg.length() );
-
-    if (out.status() != QDataStream::Ok) {
-        COPYQ_LOG("Cannot write message!");
-        return false;
-    }
-
-    COPYQ_LOG_VERBOSE("Message written.");
-    return true;
-}
-
-} //namespace
-
 ClientSocket::ClientSocket()
     : QObject()
     , m_socket()
@@ -132,11 +75,7 @@ void ClientSocket::sendMessage(const QByteArray &message, int messageCode)
     } else if (m_closed) {
         SOCKET_LOG("Client disconnected!");
     } else {
-        QByteArray msg;
-        QDataStream out(&msg, QIODevice::WriteOnly);
-        out << static_cast<qint32>(messageCode);
-        out.writeRawData( message.constData(), message.length() );
-        if ( writeMessage(m_socket, msg) )
+        if ( writeMessage(m_socket, createMessage(message, messageCode)) )
             SOCKET_LOG("Message sent to client.");
         else
             SOCKET_LOG("Failed to send message to client!");
@@ -169,6 +108,16 @@ bool ClientSocket::isClosed() const
     return m_closed;
 }
 
+void ClientSocket::setConnected(bool connected)
+{
+    Q_ASSERT( m_socket.isNull() );
+
+    if (connected)
+        m_closed = false;
+    else
+        onStateChanged(QLocalSocket::UnconnectedState);
+}
+
 void ClientSocket::onReadyRead()
 {
     if ( m_socket.isNull() ) {
@@ -184,19 +133,16 @@ void ClientSocket::onReadyRead()
 
     while (m_socket->bytesAvailable() > 0) {
         QByteArray msg;
+        QByteArray data;
+        int messageCode;
 
-        if ( !readMessage(m_socket, &msg) ) {
+        if ( !readMessage(m_socket, &msg) || !parseMessage(msg, &data, &messageCode) ) {
             log( tr("Failed to read message from client!"), LogError );
             m_socket->abort();
             onStateChanged(QLocalSocket::UnconnectedState);
             return;
         }
 
-        QDataStream stream(msg);
-        qint32 messageCode;
-        stream >> messageCode;
-        const int i = sizeof(messageCode);
-        const QByteArray data( msg.constData() + i, msg.length() - i );
         emit messageReceived(data, messageCode);
     }
 
@@ -38,17 +38,17 @@ public:
     ~ClientSocket();
 
     /// Start emiting messageReceived(). This method is thread-safe.
-    void start();
+    virtual void start();
 
 public slots:
     /** Send message to client. */
-    void sendMessage(
+    virtual void sendMessage(
             const QByteArray &message, //!< Message for client.
             int messageCode //!< Custom message code.
             );
-    void deleteAfterDisconnected();
+    virtual void deleteAfterDisconnected();
 
-    void close();
+    virtual void close();
 
     bool isClosed() const;
 
@@ -56,6 +56,10 @@ signals:
     void messageReceived(const QByteArray &message, int messageCode);
     void disconnected();
 
+protected:
+    /// Set connection state of client without socket (e.g. running in the same process).
+    void setConnected(bool connected);
+
 private slots:
     void onReadyRead();
     void onError(QLocalSocket::LocalSocketError error);
@@ -0,0 +1,45 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clipboardchangestatistics.h"
+
+#include <QMutex>
+
+namespace {
+
+QMutex countsLock;
+quint64 coalesced = 0;
+quint64 dropped = 0;
+
+} // namespace
+
+void ClipboardChangeStatistics::setCounts(quint64 coalescedCount, quint64 droppedCount)
+{
+    const QMutexLocker lock(&countsLock);
+    coalesced = coalescedCount;
+    dropped = droppedCount;
+}
+
+QString ClipboardChangeStatistics::statistics()
+{
+    const QMutexLocker lock(&countsLock);
+    return QString("%1 %2\n%3 %4\n")
+            .arg("coalesced", -9).arg(coalesced)
+            .arg("dropped", -9).arg(dropped);
+}
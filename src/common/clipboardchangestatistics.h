@@ -0,0 +1,42 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLIPBOARDCHANGESTATISTICS_H
+#define CLIPBOARDCHANGESTATISTICS_H
+
+#include <QString>
+
+/**
+ * Numbers of clipboard changes merged or dropped by clipboard monitor.
+ *
+ * Counts are reported by monitor (possibly running in other process).
+ *
+ * All methods are thread-safe.
+ */
+class ClipboardChangeStatistics
+{
+public:
+    /// Store counts reported by clipboard monitor.
+    static void setCounts(quint64 coalescedCount, quint64 droppedCount);
+
+    /// Return text with counts reported by clipboard monitor.
+    static QString statistics();
+};
+
+#endif // CLIPBOARDCHANGESTATISTICS_H
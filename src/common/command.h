@@ -39,6 +39,7 @@ struct Command {
         , re()
         , wndre()
         , matchCmd()
+        , cacheMatch(false)
         , cmd()
         , sep()
         , input()
@@ -49,6 +50,7 @@ struct Command {
         , transform(false)
         , remove(false)
         , hideWindow(false)
+        , coprocess(false)
         , enable(true)
         , icon()
         , shortcuts()
@@ -62,6 +64,7 @@ struct Command {
             && re == other.re
             && wndre == other.wndre
             && matchCmd == other.matchCmd
+            && cacheMatch == other.cacheMatch
             && cmd == other.cmd
             && sep == other.sep
             && input == other.input
@@ -72,6 +75,7 @@ struct Command {
             && transform == other.transform
             && remove == other.remove
             && hideWindow == other.hideWindow
+            && coprocess == other.coprocess
             && enable == other.enable
             && icon == other.icon
             && shortcuts == other.shortcuts
@@ -100,6 +104,12 @@ struct Command {
      */
     QString matchCmd;
 
+    /**
+     * If true result of matchCmd is cached for item data.
+     * The program should depend only on the data.
+     */
+    bool cacheMatch;
+
     /**
      * Program to execute on matched items.
      * Contains space separated list of arguments.
@@ -137,6 +147,12 @@ struct Command {
     /** If true close window after command is activated from menu. */
     bool hideWindow;
 
+    /**
+     * If true keep program running and pass it each input as a record
+     * (size in bytes, new line, data); program replies with output record.
+     */
+    bool coprocess;
+
     /** If false command is disabled and should not be used. */
     bool enable;
 
@@ -0,0 +1,152 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "commandmatcher.h"
+
+#include "common/common.h"
+#include "common/mimetypes.h"
+
+#include <QBitArray>
+
+namespace {
+
+enum MatchState {
+    NotEvaluated,
+    Matched,
+    NotMatched
+};
+
+/// Evaluate regular expression only once for all commands.
+bool matches(const QRegExp &re, const QString &text, MatchState *state)
+{
+    if (*state == NotEvaluated)
+        *state = re.indexIn(text) != -1 ? Matched : NotMatched;
+    return *state == Matched;
+}
+
+} // namespace
+
+CommandMatcher::CommandMatcher()
+    : m_commands()
+    , m_compiled()
+    , m_textRegExps()
+    , m_windowRegExps()
+    , m_formats()
+{
+}
+
+void CommandMatcher::setCommands(const QList<Command> &commands)
+{
+    m_commands = commands;
+    m_compiled.clear();
+    m_textRegExps.clear();
+    m_windowRegExps.clear();
+    m_formats.clear();
+
+    m_compiled.reserve( commands.size() );
+
+    foreach (const Command &command, commands) {
+        CompiledCommand compiled;
+        compiled.hasAction = !command.cmd.isEmpty() || command.remove;
+        compiled.re = command.re.isEmpty() ? -1 : addRegExp(command.re, &m_textRegExps);
+        compiled.wndre = command.wndre.isEmpty() ? -1 : addRegExp(command.wndre, &m_windowRegExps);
+
+        // Disallow applying action that takes serialized item more times.
+        const bool takesItem = command.input == mimeItems;
+        compiled.input = (command.input.isEmpty() || takesItem) ? -1 : addFormat(command.input);
+        compiled.output = takesItem ? addFormat(command.output) : -1;
+
+        m_compiled.append(compiled);
+    }
+}
+
+QList<int> CommandMatcher::match(const QVariantMap &data, const QString &sourceTabName) const
+{
+    QBitArray availableFormats( m_formats.size() );
+    for (int i = 0; i < m_formats.size(); ++i)
+        availableFormats.setBit( i, data.contains(m_formats[i]) );
+
+    const bool hasText = data.contains(mimeText);
+
+    // Text and window title are decoded only if some regular expression needs them.
+    QString text;
+    QString windowTitle;
+    bool textDecoded = false;
+
+    QVector<MatchState> textStates( m_textRegExps.size(), NotEvaluated );
+    QVector<MatchState> windowStates( m_windowRegExps.size(), NotEvaluated );
+
+    QList<int> result;
+
+    for (int i = 0; i < m_compiled.size(); ++i) {
+        const CompiledCommand &c = m_compiled[i];
+
+        if ( !c.hasAction ) {
+            const QString &tab = m_commands[i].tab;
+            if ( tab.isEmpty() || tab == sourceTabName )
+                continue;
+        }
+
+        if ( c.input != -1 && !availableFormats.testBit(c.input) )
+            continue;
+
+        if ( c.output != -1 && availableFormats.testBit(c.output) )
+            continue;
+
+        // Verify that text is present when regex is defined.
+        if ( c.re != -1 && !hasText )
+            continue;
+
+        if ( (c.re != -1 || c.wndre != -1) && !textDecoded ) {
+            text = getTextData(data);
+            windowTitle = data.value(mimeWindowTitle).toString();
+            textDecoded = true;
+        }
+
+        if ( c.re != -1 && !matches(m_textRegExps[c.re], text, &textStates[c.re]) )
+            continue;
+
+        if ( c.wndre != -1 && !matches(m_windowRegExps[c.wndre], windowTitle, &windowStates[c.wndre]) )
+            continue;
+
+        result.append(i);
+    }
+
+    return result;
+}
+
+int CommandMatcher::addRegExp(const QRegExp &re, QVector<QRegExp> *regExps)
+{
+    const int i = regExps->indexOf(re);
+    if (i != -1)
+        return i;
+
+    regExps->append(re);
+    return regExps->size() - 1;
+}
+
+int CommandMatcher::addFormat(const QString &format)
+{
+    const int i = m_formats.indexOf(format);
+    if (i != -1)
+        return i;
+
+    m_formats.append(format);
+    return m_formats.size() - 1;
+}
@@ -0,0 +1,76 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMMANDMATCHER_H
+#define COMMANDMATCHER_H
+
+#include "common/command.h"
+
+#include <QList>
+#include <QRegExp>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+/**
+ * Finds commands that can be executed for given item data.
+ *
+ * Commands are compiled once (when they change). Identical regular
+ * expressions are shared by commands and each is evaluated at most once per
+ * match() call, required input formats are checked against bit set of
+ * available formats and text is decoded from item data only once.
+ */
+class CommandMatcher
+{
+public:
+    CommandMatcher();
+
+    /** Compile commands for matching. */
+    void setCommands(const QList<Command> &commands);
+
+    const QList<Command> &commands() const { return m_commands; }
+
+    /**
+     * Return indexes of commands that can be executed for item @a data.
+     *
+     * Commands without action that would only copy item to @a sourceTabName
+     * are skipped. Commands with "matchCmd" still need to be tested.
+     */
+    QList<int> match(const QVariantMap &data, const QString &sourceTabName) const;
+
+private:
+    struct CompiledCommand {
+        bool hasAction; ///< Command runs program or removes item.
+        int re;         ///< Index of text regular expression or -1 to match all.
+        int wndre;      ///< Index of window title regular expression or -1 to match all.
+        int input;      ///< Index of required format or -1.
+        int output;     ///< Index of format that mustn't be present or -1.
+    };
+
+    static int addRegExp(const QRegExp &re, QVector<QRegExp> *regExps);
+    int addFormat(const QString &format);
+
+    QList<Command> m_commands;
+    QVector<CompiledCommand> m_compiled;
+    QVector<QRegExp> m_textRegExps;
+    QVector<QRegExp> m_windowRegExps;
+    QStringList m_formats;
+};
+
+#endif // COMMANDMATCHER_H
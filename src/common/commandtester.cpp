@@ -22,42 +22,100 @@
 #include "common/action.h"
 #include "common/common.h"
 #include "common/mimetypes.h"
+#include "item/serialize.h"
 
+#include <QCache>
+#include <QCryptographicHash>
 #include <QProcess>
 #include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+
+namespace {
+
+/// Filter program is terminated after this time (it fails the test).
+const int testTimeoutMs = 10000;
+
+/// Filter program is killed if it doesn't exit in this time after terminating.
+const int killTimeoutMs = 1000;
+
+/// Cached filter results (shared by all testers in main thread).
+QCache<QByteArray, bool> &matchCache()
+{
+    static QCache<QByteArray, bool> cache(1000);
+    return cache;
+}
+
+QByteArray matchCacheKey(const QString &matchCmd, const QByteArray &serializedData)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData( matchCmd.toUtf8() );
+    hash.addData( QByteArray(1, '\0') );
+    hash.addData(serializedData);
+    return hash.result();
+}
+
+int maxRunningTests()
+{
+    return qMax(2, QThread::idealThreadCount());
+}
+
+} // namespace
 
 CommandTester::CommandTester(QObject *parent)
     : QObject(parent)
-    , m_action(NULL)
-    , m_abort(false)
+    , m_tests()
+    , m_data()
+    , m_actions()
+    , m_timeoutMs(testTimeoutMs)
+    , m_maxRunning( maxRunningTests() )
 {
 }
 
 void CommandTester::abort()
 {
-    m_commands.clear();
+    // Running filter programs are left to finish but their results are ignored.
+    m_tests.clear();
     m_data.clear();
-
-    if (m_action)
-        m_abort = true;
 }
 
 void CommandTester::setCommands(
         const QList<Command> &commands, const QVariantMap &data)
 {
     abort();
-    m_commands = commands;
+
+    QByteArray serializedData;
+
+    foreach (const Command &command, commands) {
+        Test test;
+        test.command = command;
+        test.state = command.matchCmd.isEmpty() ? TestPassed : TestPending;
+        test.action = NULL;
+
+        if (test.state == TestPending && command.cacheMatch) {
+            if ( serializedData.isEmpty() )
+                serializedData = serializeData(data);
+            test.cacheKey = matchCacheKey(command.matchCmd, serializedData);
+
+            const bool *passed = matchCache().object(test.cacheKey);
+            if (passed)
+                test.state = *passed ? TestPassed : TestFailed;
+        }
+
+        m_tests.append(test);
+    }
+
     m_data = data;
 }
 
 bool CommandTester::isCompleted() const
 {
-    return !m_action;
+    return m_actions.isEmpty();
 }
 
 bool CommandTester::hasCommands() const
 {
-    return !m_commands.isEmpty();
+    return !m_tests.isEmpty();
 }
 
 const QVariantMap &CommandTester::data() const
@@ -67,66 +125,89 @@ const QVariantMap &CommandTester::data() const
 
 void CommandTester::start()
 {
-    if (!m_action)
-        startNext();
+    emitFinished();
+    startPending();
 }
 
-void CommandTester::actionFinished()
+void CommandTester::actionFinished(Action *action)
 {
-    Q_ASSERT(m_action);
-    Q_ASSERT(!m_action->isRunning());
-
-    bool passed = !m_action->actionFailed() && m_action->exitCode() == 0;
-    m_action->deleteLater();
-    m_action = NULL;
-
-    if (m_abort) {
-        start();
-    } else {
-        commandPassed(passed);
-        if (!maybeFinish())
-            startNext();
+    Q_ASSERT(!action->isRunning());
+
+    m_actions.removeOne(action);
+    action->deleteLater();
+
+    for (int i = 0; i < m_tests.size(); ++i) {
+        Test &test = m_tests[i];
+        if (test.action == action) {
+            const bool passed = !action->actionFailed() && action->exitCode() == 0;
+            test.state = passed ? TestPassed : TestFailed;
+            test.action = NULL;
+
+            // Don't cache failure to start or crash of the filter program.
+            if ( !test.cacheKey.isEmpty() && !action->actionFailed() )
+                matchCache().insert( test.cacheKey, new bool(passed) );
+            break;
+        }
     }
+
+    start();
 }
 
-void CommandTester::startNext()
+void CommandTester::emitFinished()
 {
-    Q_ASSERT(!m_action);
+    while ( !m_tests.isEmpty() ) {
+        const TestState state = m_tests.first().state;
+        if (state != TestPassed && state != TestFailed)
+            break;
+
+        // Receiver can abort or set new commands.
+        const Command command = m_tests.takeFirst().command;
+        emit commandPassed(command, state == TestPassed);
+    }
+}
 
-    m_abort = false;
+void CommandTester::startPending()
+{
+    // Tests can be finished and removed while starting next one (if a program fails to start).
+    while ( m_actions.size() < m_maxRunning ) {
+        int i = 0;
+        while ( i < m_tests.size() && m_tests[i].state != TestPending )
+            ++i;
 
-    if (!maybeFinish()) {
-        Command *command = &m_commands[0];
+        if ( i == m_tests.size() )
+            break;
 
-        while (command->matchCmd.isEmpty()) {
-            commandPassed(true);
-            if (maybeFinish())
-                return;
-            command = &m_commands[0];
-        }
+        startTest(&m_tests[i]);
+    }
+}
 
-        m_action = new Action(this);
+void CommandTester::startTest(Test *test)
+{
+    Action *action = new Action(this);
 
-        const QString text = getTextData(m_data);
-        m_action->setInput(text.toUtf8());
-        m_action->setData(m_data);
+    const QString text = getTextData(m_data);
+    action->setInput(text.toUtf8());
+    action->setData(m_data);
+    action->setCommand(test->command.matchCmd, QStringList(text));
 
-        const QString arg = QString::fromUtf8(m_action->input());
-        m_action->setCommand(command->matchCmd, QStringList(arg));
+    test->state = TestRunning;
+    test->action = action;
+    m_actions.append(action);
 
-        connect(m_action, SIGNAL(actionFinished(Action*)), SLOT(actionFinished()));
-        m_action->start();
-    }
-}
+    // Test fails after timeout; result is handled when the program finishes.
+    QTimer *timer = new QTimer(action);
+    timer->setSingleShot(true);
+    timer->setInterval(m_timeoutMs);
+    connect(timer, SIGNAL(timeout()), action, SLOT(terminate()));
 
-void CommandTester::commandPassed(bool passed)
-{
-    Q_ASSERT(hasCommands());
-    const Command command = m_commands.takeFirst();
-    emit commandPassed(command, passed);
-}
+    QTimer *killTimer = new QTimer(action);
+    killTimer->setSingleShot(true);
+    killTimer->setInterval(killTimeoutMs);
+    connect(timer, SIGNAL(timeout()), killTimer, SLOT(start()));
+    connect(killTimer, SIGNAL(timeout()), action, SLOT(kill()));
 
-bool CommandTester::maybeFinish()
-{
-    return !hasCommands();
+    timer->start();
+
+    connect(action, SIGNAL(actionFinished(Action*)), SLOT(actionFinished(Action*)));
+    action->start();
 }
@@ -29,6 +29,15 @@ Q_DECLARE_METATYPE(Command)
 
 class Action;
 
+/**
+ * Tests commands for given data using Command::matchCmd filter programs.
+ *
+ * Independent filters run concurrently (up to a limit) and each one is
+ * terminated after a timeout (and killed if it doesn't exit shortly after).
+ * Results are emitted in the original order.
+ *
+ * Results of commands with Command::cacheMatch are cached for item data.
+ */
 class CommandTester : public QObject
 {
     Q_OBJECT
@@ -41,12 +50,19 @@ public:
     /// Abort current processing set new commands and data.
     void setCommands(const QList<Command> &commands, const QVariantMap &data);
 
+    /// Return true only if no filter program is running.
     bool isCompleted() const;
 
     bool hasCommands() const;
 
     const QVariantMap &data() const;
 
+    /// Set time limit for filter programs (default is 10 seconds).
+    void setTimeout(int ms) { m_timeoutMs = ms; }
+
+    /// Set maximum number of concurrently running filter programs.
+    void setMaxRunning(int count) { m_maxRunning = count; }
+
 public slots:
     void start();
 
@@ -54,17 +70,40 @@ signals:
     void commandPassed(const Command &command, bool passed);
 
 private slots:
-    void actionFinished();
+    void actionFinished(Action *action);
 
 private:
-    void startNext();
-    void commandPassed(bool passed);
-    bool maybeFinish();
-
-    QList<Command> m_commands;
+    enum TestState {
+        TestPending,
+        TestRunning,
+        TestPassed,
+        TestFailed
+    };
+
+    struct Test {
+        Command command;
+        TestState state;
+        Action *action;
+        QByteArray cacheKey; ///< Empty if result should not be cached.
+    };
+
+    /// Emit results of finished tests at the beginning of the queue.
+    void emitFinished();
+
+    /// Start pending tests up to the limit of concurrently running filters.
+    void startPending();
+
+    /// Start filter program for test (can finish and remove the test immediately).
+    void startTest(Test *test);
+
+    QList<Test> m_tests;
     QVariantMap m_data;
-    Action *m_action;
-    bool m_abort;
+
+    /// Running filter programs (including ones for aborted tests).
+    QList<Action*> m_actions;
+
+    int m_timeoutMs;
+    int m_maxRunning;
 };
 
 #endif // COMMANDTESTER_H
@@ -32,9 +32,13 @@
 #include <QLocale>
 #include <QMimeData>
 #include <QObject>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSharedPointer>
 #include <QTemporaryFile>
 #include <QTextCodec>
 #include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QUrl>
 #if QT_VERSION < 0x050000
@@ -50,8 +54,27 @@ QString getImageFormatFromMime(const QString &mime)
                                             : QString();
 }
 
-QImage getImageData(const QMimeData &data)
-{
+/// Maximum memory (in bytes) for image data encoded concurrently.
+const qint64 maxConcurrentImageEncodingBytes = 256 * 1024 * 1024;
+
+/**
+ * Return image decoded from any image format already cloned in @a dataMap,
+ * otherwise fetch the image from clipboard @a data.
+ */
+QImage getImageData(const QMimeData &data, const QVariantMap &dataMap)
+{
+    foreach ( const QString &mime, dataMap.keys() ) {
+        const QString format = getImageFormatFromMime(mime);
+        if ( !format.isEmpty() ) {
+            const QImage image = QImage::fromData(
+                        dataMap[mime].toByteArray(), format.toUtf8().constData() );
+            if ( !image.isNull() ) {
+                COPYQ_LOG( QString("Decoded image from \"%1\"").arg(mime) );
+                return image;
+            }
+        }
+    }
+
     // NOTE: Application hangs if using mulitple sessions and
     //       calling QMimeData::hasImage() on X11 clipboard.
     COPYQ_LOG("Fething image data from clipboard");
@@ -60,26 +83,94 @@ QImage getImageData(const QMimeData &data)
     return image;
 }
 
+/// Encodes image to single format; can run in thread pool.
+class ImageEncoder : public QRunnable
+{
+public:
+    ImageEncoder(const QImage &image, const QString &mime, QSemaphore *finished = NULL)
+        : m_image(image)
+        , m_mime(mime)
+        , m_finished(finished)
+        , m_saved(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        QBuffer buffer(&m_bytes);
+        buffer.open(QIODevice::WriteOnly);
+        const QString format = getImageFormatFromMime(m_mime);
+        m_saved = m_image.save(&buffer, format.toUtf8().constData());
+
+        if (m_finished)
+            m_finished->release();
+    }
+
+    void insertTo(QVariantMap *dataMap) const
+    {
+        COPYQ_LOG( QString("Converting image to \"%1\" format: %2")
+                   .arg(m_mime)
+                   .arg(m_saved ? "Done" : "Failed") );
+
+        if (m_saved)
+            dataMap->insert(m_mime, m_bytes);
+    }
+
+private:
+    const QImage m_image;
+    const QString m_mime;
+    QSemaphore *m_finished;
+    QByteArray m_bytes;
+    bool m_saved;
+};
+
+QThreadPool *imageEncoderThreadPool()
+{
+    static QThreadPool pool;
+    return &pool;
+}
+
 /**
  * Sometimes only Qt internal image data are available in cliboard,
- * so this tries to convert the image data (if available) to given format.
+ * so this tries to convert the image data (if available) to given formats.
+ *
+ * Image is decoded only once and missing formats are encoded in parallel
+ * unless it would take too much memory.
  */
-void cloneImageData(
-        const QImage &image, const QString &format,
-        const QString &mime, QVariantMap *dataMap)
+void cloneImageData(const QImage &image, const QStringList &mimes, QVariantMap *dataMap)
 {
-    if (image.isNull())
+    if ( image.isNull() || mimes.isEmpty() )
         return;
 
-    QBuffer buffer;
-    bool saved = image.save(&buffer, format.toUtf8().constData());
+    QList< QSharedPointer<ImageEncoder> > encoders;
+
+    // Each encoder needs buffer roughly as big as the raw image.
+    const qint64 bytesPerEncoder = qMax(1, image.byteCount());
+    const bool parallel = mimes.size() > 1
+            && bytesPerEncoder * mimes.size() <= maxConcurrentImageEncodingBytes;
+
+    if (parallel) {
+        QSemaphore finished;
+        for (int i = 1; i < mimes.size(); ++i) {
+            encoders.append( QSharedPointer<ImageEncoder>(new ImageEncoder(image, mimes[i], &finished)) );
+            imageEncoderThreadPool()->start( encoders.last().data() );
+        }
 
-    COPYQ_LOG( QString("Converting image to \"%1\" format: %2")
-               .arg(format)
-               .arg(saved ? "Done" : "Failed") );
+        ImageEncoder encoder(image, mimes[0]);
+        encoder.run();
+        encoder.insertTo(dataMap);
 
-    if (saved)
-        dataMap->insert(mime, buffer.buffer());
+        finished.acquire(encoders.size());
+    } else {
+        foreach (const QString &mime, mimes) {
+            encoders.append( QSharedPointer<ImageEncoder>(new ImageEncoder(image, mime)) );
+            encoders.last()->run();
+        }
+    }
+
+    foreach (const QSharedPointer<ImageEncoder> &encoder, encoders)
+        encoder->insertTo(dataMap);
 }
 
 bool setImageData(const QVariantMap &data, const QString &mime, QMimeData *mimeData)
@@ -218,25 +309,20 @@ QVariantMap cloneData(const QMimeData &data, const QStringList &formats)
 
     QVariantMap newdata;
 
-    QImage image;
-    bool imageLoaded = false;
+    // Keep native formats, convert image to other formats afterwards.
+    QStringList missingImageFormats;
 
     foreach (const QString &mime, formats) {
         const QByteArray bytes = getUtf8Data(data, mime);
-        if ( !bytes.isEmpty() ) {
+        if ( !bytes.isEmpty() )
             newdata.insert(mime, bytes);
-        } else if ( !imageLoaded || !image.isNull() ) {
-            const QString format = getImageFormatFromMime(mime);
-            if ( !format.isEmpty() ) {
-                if (!imageLoaded) {
-                    image = getImageData(data);
-                    imageLoaded = true;
-                }
-                cloneImageData(image, format, mime, &newdata);
-            }
-        }
+        else if ( !getImageFormatFromMime(mime).isEmpty() )
+            missingImageFormats.append(mime);
     }
 
+    if ( !missingImageFormats.isEmpty() )
+        cloneImageData( getImageData(data, newdata), missingImageFormats, &newdata );
+
     foreach (const QString &internalMime, internalMimeTypes) {
         if ( data.hasFormat(internalMime) )
             newdata.insert( internalMime, data.data(internalMime) );
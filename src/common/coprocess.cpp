@@ -0,0 +1,259 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "coprocess.h"
+
+#include "common/action.h"
+#include "common/log.h"
+
+#include <QCoreApplication>
+#include <QHash>
+
+namespace {
+
+/// Program is stopped after it doesn't receive any input for this time.
+const int idleTimeoutMs = 60000;
+
+/// Program is killed if it doesn't exit after its input is closed.
+const int exitTimeoutMs = 5000;
+
+QHash<QString, Coprocess*> coprocesses;
+
+QString coprocessKey(const QStringList &args)
+{
+    return args.join( QString(QChar(0)) );
+}
+
+} // namespace
+
+Coprocess *Coprocess::instance(const QStringList &args)
+{
+    const QString key = coprocessKey(args);
+    Coprocess *coprocess = coprocesses.value(key);
+    if (coprocess == NULL) {
+        coprocess = new Coprocess(args);
+        coprocesses.insert(key, coprocess);
+    }
+
+    return coprocess;
+}
+
+void Coprocess::request(Action *action, const QByteArray &input)
+{
+    m_idleTimer.stop();
+
+    if ( !ensureStarted() ) {
+        action->coprocessFinished( QByteArray(), tr("Failed to start program") );
+        return;
+    }
+
+    m_pending.enqueue(action);
+
+    const QByteArray record = QByteArray::number(input.size()) + '\n' + input;
+    if ( m_process->state() == QProcess::Running )
+        m_process->write(record);
+    else
+        m_input.append(record);
+}
+
+void Coprocess::cancel(Action *action)
+{
+    // Keep the request in queue so output records are still matched in order.
+    for (int i = 0; i < m_pending.size(); ++i) {
+        if (m_pending[i] == action)
+            m_pending[i] = NULL;
+    }
+}
+
+void Coprocess::onStarted()
+{
+    m_process->write(m_input);
+    m_input.clear();
+}
+
+void Coprocess::onError(QProcess::ProcessError error)
+{
+    // Other errors are handled when program finishes.
+    if (error != QProcess::FailedToStart)
+        return;
+
+    const QString errorString = m_process->errorString();
+    COPYQ_LOG( QString("Coprocess \"%1\": %2").arg(m_args.join(" "), errorString) );
+
+    clearProcess();
+    failPending(errorString);
+
+    if ( !isRegistered() )
+        deleteLater();
+}
+
+void Coprocess::onReadyReadStandardOutput()
+{
+    m_output.append( m_process->readAllStandardOutput() );
+
+    QByteArray record;
+    while ( readRecord(&record) ) {
+        if ( m_pending.isEmpty() ) {
+            log( QString("Coprocess \"%1\": Unexpected output").arg(m_args.join(" ")), LogWarning );
+            continue;
+        }
+
+        const QPointer<Action> action = m_pending.dequeue();
+        if (action)
+            action->coprocessFinished(record, QString());
+    }
+
+    if ( m_pending.isEmpty() )
+        m_idleTimer.start();
+}
+
+void Coprocess::onReadyReadStandardError()
+{
+    const QByteArray errorOutput = m_process->readAllStandardError();
+
+    // Error output belongs to the oldest request.
+    Action *action = m_pending.isEmpty() ? NULL : m_pending.head().data();
+    if (action)
+        action->appendErrorOutput(errorOutput);
+    else
+        COPYQ_LOG( QString("Coprocess \"%1\": %2").arg(m_args.join(" "), QString::fromUtf8(errorOutput)) );
+}
+
+void Coprocess::onFinished()
+{
+    COPYQ_LOG( QString("Coprocess \"%1\": Finished").arg(m_args.join(" ")) );
+
+    clearProcess();
+    failPending( tr("Program exited before processing input") );
+
+    // Program stopped after idle timeout is not started again.
+    if ( !isRegistered() )
+        deleteLater();
+}
+
+void Coprocess::onIdleTimeout()
+{
+    COPYQ_LOG( QString("Coprocess \"%1\": Stopping idle program").arg(m_args.join(" ")) );
+
+    if ( isRegistered() )
+        coprocesses.remove( coprocessKey(m_args) );
+
+    if (m_process) {
+        m_process->closeWriteChannel();
+        QTimer::singleShot( exitTimeoutMs, m_process, SLOT(kill()) );
+    } else {
+        deleteLater();
+    }
+}
+
+Coprocess::Coprocess(const QStringList &args)
+    : QObject( QCoreApplication::instance() )
+    , m_args(args)
+    , m_process(NULL)
+    , m_pending()
+    , m_input()
+    , m_output()
+    , m_idleTimer()
+{
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(idleTimeoutMs);
+    connect( &m_idleTimer, SIGNAL(timeout()), this, SLOT(onIdleTimeout()) );
+}
+
+Coprocess::~Coprocess()
+{
+    if ( isRegistered() )
+        coprocesses.remove( coprocessKey(m_args) );
+    failPending( tr("Program was stopped") );
+}
+
+bool Coprocess::isRegistered() const
+{
+    return coprocesses.value( coprocessKey(m_args) ) == this;
+}
+
+bool Coprocess::ensureStarted()
+{
+    if (m_process)
+        return true;
+
+    COPYQ_LOG( QString("Coprocess \"%1\": Starting").arg(m_args.join(" ")) );
+
+    m_process = new QProcess(this);
+    m_process->setProcessEnvironment( Action::processEnvironment() );
+    connect( m_process, SIGNAL(started()),
+             this, SLOT(onStarted()) );
+    connect( m_process, SIGNAL(error(QProcess::ProcessError)),
+             this, SLOT(onError(QProcess::ProcessError)) );
+    connect( m_process, SIGNAL(readyReadStandardOutput()),
+             this, SLOT(onReadyReadStandardOutput()) );
+    connect( m_process, SIGNAL(readyReadStandardError()),
+             this, SLOT(onReadyReadStandardError()) );
+    connect( m_process, SIGNAL(finished(int,QProcess::ExitStatus)),
+             this, SLOT(onFinished()) );
+
+    Action::startProcess(m_process, m_args);
+
+    // Failure to start can be reported before returning from QProcess::start().
+    return m_process != NULL;
+}
+
+void Coprocess::clearProcess()
+{
+    m_process->disconnect(this);
+    m_process->deleteLater();
+    m_process = NULL;
+    m_input.clear();
+    m_output.clear();
+}
+
+void Coprocess::failPending(const QString &error)
+{
+    // Actions can enqueue new requests from coprocessFinished().
+    const QQueue< QPointer<Action> > pending = m_pending;
+    m_pending.clear();
+
+    foreach (const QPointer<Action> &action, pending) {
+        if (action)
+            action->coprocessFinished(QByteArray(), error);
+    }
+}
+
+bool Coprocess::readRecord(QByteArray *record)
+{
+    const int i = m_output.indexOf('\n');
+    if (i == -1)
+        return false;
+
+    bool ok;
+    const int size = m_output.left(i).trimmed().toInt(&ok);
+    if (!ok || size < 0) {
+        log( QString("Coprocess \"%1\": Bad output record").arg(m_args.join(" ")), LogWarning );
+        m_output.clear();
+        failPending( tr("Bad output record") );
+        return false;
+    }
+
+    if (m_output.size() < i + 1 + size)
+        return false;
+
+    *record = m_output.mid(i + 1, size);
+    m_output.remove(0, i + 1 + size);
+    return true;
+}
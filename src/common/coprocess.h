@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COPROCESS_H
+#define COPROCESS_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QQueue>
+#include <QStringList>
+#include <QTimer>
+
+class Action;
+
+/**
+ * Long-running program which processes inputs of many actions.
+ *
+ * Program is started with first request and keeps running until it's idle
+ * for some time. Each input is written to program's standard input as
+ * a record and program is expected to write one output record for each
+ * input record in the same order.
+ *
+ * Record consists of data length in bytes (decimal number) followed by
+ * new line and the data.
+ *
+ * Program is started without waiting; records are written after it starts.
+ *
+ * If program exits or crashes, pending requests fail and program is started
+ * again with next request.
+ */
+class Coprocess : public QObject
+{
+    Q_OBJECT
+public:
+    /// Return coprocess for command line arguments (created if needed).
+    static Coprocess *instance(const QStringList &args);
+
+    /// Send input record; Action::coprocessFinished() is called with result.
+    void request(Action *action, const QByteArray &input);
+
+    /// Ignore result for action.
+    void cancel(Action *action);
+
+private slots:
+    void onStarted();
+    void onError(QProcess::ProcessError error);
+    void onReadyReadStandardOutput();
+    void onReadyReadStandardError();
+    void onFinished();
+    void onIdleTimeout();
+
+private:
+    explicit Coprocess(const QStringList &args);
+
+    ~Coprocess();
+
+    bool isRegistered() const;
+
+    /// Start program if it's not running (returns false if it failed immediately).
+    bool ensureStarted();
+
+    /// Delete program (after it exited or failed to start).
+    void clearProcess();
+
+    /// Fail all pending requests.
+    void failPending(const QString &error);
+
+    /// Try to parse next output record; returns false if data are incomplete.
+    bool readRecord(QByteArray *record);
+
+    QStringList m_args;
+    QProcess *m_process;
+    QQueue< QPointer<Action> > m_pending;
+    QByteArray m_input; ///< Records to write after program starts.
+    QByteArray m_output;
+    QTimer m_idleTimer;
+};
+
+#endif // COPROCESS_H
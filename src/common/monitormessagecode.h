@@ -29,7 +29,8 @@ enum MonitorMessageCode {
     MonitorChangeSelection,
     MonitorClipboardChanged,
     MonitorIgnoreClipboard,
-    MonitorLog
+    MonitorLog,
+    MonitorStatistics
 };
 
 #endif // MONITORMESSAGECODE_H
@@ -1590,6 +1590,33 @@ bool ClipboardBrowser::add(const QVariantMap &data, int row)
     return true;
 }
 
+bool ClipboardBrowser::appendItems(const QList<QVariantMap> &items)
+{
+    if ( m.isDisabled() )
+        return false;
+    if ( !isLoaded() ) {
+        loadItems();
+        if ( !isLoaded() )
+            return false;
+    }
+
+    const int firstRow = m.rowCount();
+    const int count = qMin( items.size(), m_sharedData->maxItems - firstRow );
+    if (count <= 0)
+        return true;
+
+    m.insertItems( items.mid(0, count), firstRow );
+
+    for (int row = firstRow; row < firstRow + count; ++row) {
+        if ( isFiltered(row) )
+            setRowHidden(row, true);
+    }
+
+    delayedSaveItems();
+
+    return true;
+}
+
 void ClipboardBrowser::loadSettings()
 {
     ConfigurationManager *cm = ConfigurationManager::instance();
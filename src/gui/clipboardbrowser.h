@@ -176,6 +176,13 @@ class ClipboardBrowser : public QListView
                 int row = 0 //!< Target row for the new item (negative to append item).
                 );
 
+        /**
+         * Append new items to the browser at once.
+         *
+         * Unlike add(), current item and selection are not changed.
+         */
+        bool appendItems(const QList<QVariantMap> &items);
+
         /** Number of items in list. */
         int length() const { return model()->rowCount(); }
 
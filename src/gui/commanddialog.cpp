@@ -56,6 +56,7 @@ void loadCommand(const QSettings &settings, bool onlyEnabled, CommandDialog::Com
     c.re   = QRegExp( settings.value("Match").toString() );
     c.wndre = QRegExp( settings.value("Window").toString() );
     c.matchCmd = settings.value("MatchCommand").toString();
+    c.cacheMatch = settings.value("CacheMatch").toBool();
     c.cmd = settings.value("Command").toString();
     c.sep = settings.value("Separator").toString();
 
@@ -71,6 +72,7 @@ void loadCommand(const QSettings &settings, bool onlyEnabled, CommandDialog::Com
     c.automatic = settings.value("Automatic").toBool();
     c.transform = settings.value("Transform").toBool();
     c.hideWindow = settings.value("HideWindow").toBool();
+    c.coprocess = settings.value("Coprocess").toBool();
     c.icon = settings.value("Icon").toString();
     c.shortcuts = settings.value("Shortcut").toStringList();
     c.globalShortcuts = settings.value("GlobalShortcut").toStringList();
@@ -137,6 +139,7 @@ void saveCommand(const Command &c, QSettings *settings)
     saveNewValue("Match", c, &Command::re, settings);
     saveNewValue("Window", c, &Command::wndre, settings);
     saveNewValue("MatchCommand", c, &Command::matchCmd, settings);
+    saveNewValue("CacheMatch", c, &Command::cacheMatch, settings);
     saveNewValue("Command", c, &Command::cmd, settings);
     saveNewValue("Input", c, &Command::input, settings);
     saveNewValue("Output", c, &Command::output, settings);
@@ -152,6 +155,7 @@ void saveCommand(const Command &c, QSettings *settings)
     saveNewValue("Transform", c, &Command::transform, settings);
     saveNewValue("Remove", c, &Command::remove, settings);
     saveNewValue("HideWindow", c, &Command::hideWindow, settings);
+    saveNewValue("Coprocess", c, &Command::coprocess, settings);
     saveNewValue("Enable", c, &Command::enable, settings);
     saveNewValue("Icon", c, &Command::icon, settings);
     saveNewValue("Shortcut", c, &Command::shortcuts, settings);
@@ -127,6 +127,7 @@ Command CommandWidget::command() const
     c.re     = QRegExp( ui->lineEditMatch->text() );
     c.wndre  = QRegExp( ui->lineEditWindow->text() );
     c.matchCmd = ui->lineEditMatchCmd->text();
+    c.cacheMatch = ui->checkBoxCacheMatch->isChecked();
     c.cmd    = ui->commandEdit->command();
     c.sep    = ui->lineEditSeparator->text();
     c.input  = ui->comboBoxInputFormat->currentText();
@@ -137,6 +138,7 @@ Command CommandWidget::command() const
     c.transform = ui->checkBoxTransform->isChecked();
     c.remove = ui->checkBoxIgnore->isChecked();
     c.hideWindow = ui->checkBoxHideWindow->isChecked();
+    c.coprocess = ui->checkBoxCoprocess->isChecked();
     c.enable = true;
     c.icon   = ui->buttonIcon->currentIcon();
     c.shortcuts = serializeShortcuts( ui->shortcutButton->shortcuts() );
@@ -155,6 +157,7 @@ void CommandWidget::setCommand(const Command &c)
     ui->lineEditMatch->setText( c.re.pattern() );
     ui->lineEditWindow->setText( c.wndre.pattern() );
     ui->lineEditMatchCmd->setText(c.matchCmd);
+    ui->checkBoxCacheMatch->setChecked(c.cacheMatch);
     ui->commandEdit->setCommand(c.cmd);
     ui->lineEditSeparator->setText(c.sep);
     ui->comboBoxInputFormat->setEditText(c.input);
@@ -165,6 +168,7 @@ void CommandWidget::setCommand(const Command &c)
     ui->checkBoxTransform->setChecked(c.transform);
     ui->checkBoxIgnore->setChecked(c.remove);
     ui->checkBoxHideWindow->setChecked(c.hideWindow);
+    ui->checkBoxCoprocess->setChecked(c.coprocess);
     ui->buttonIcon->setCurrentIcon(c.icon);
     deserializeShortcuts(c.shortcuts, ui->shortcutButton);
     deserializeShortcuts(
@@ -145,6 +145,7 @@ ItemLoaderInterfacePtr ConfigurationManager::loadItems(ClipboardModel &model)
     ItemLoaderInterfacePtr loader;
 
     model.setDisabled(true);
+    model.setLoading(true);
 
     if ( file.exists() ) {
         COPYQ_LOG( QString("Tab \"%1\": Loading items").arg(tabName) );
@@ -170,6 +171,7 @@ ItemLoaderInterfacePtr ConfigurationManager::loadItems(ClipboardModel &model)
     }
 
     model.setDisabled(!loader);
+    model.setLoading(false);
 
     return loader;
 }
@@ -473,6 +475,9 @@ void ConfigurationManager::initOptions()
 
     /* other options */
     bind("command_history_size", 100);
+    bind("clipboard_change_delay", 0);
+    bind("clipboard_max_change_rate", 0);
+    bind("monitor_in_process", false);
 #ifdef COPYQ_WS_X11
     /* X11 clipboard selection monitoring and synchronization */
     bind("check_selection", ui->checkBoxSel, false);
@@ -88,40 +88,6 @@ bool canPaste()
     return !QApplication::queryKeyboardModifiers().testFlag(Qt::ControlModifier);
 }
 
-bool canExecuteCommand(const Command &command, const QVariantMap &data, const QString &sourceTabName)
-{
-    // Verify that an action is provided.
-    if ( command.cmd.isEmpty() && !command.remove
-         && (command.tab.isEmpty() || command.tab == sourceTabName) )
-    {
-        return false;
-    }
-
-    // Verify that data for given MIME is available.
-    if ( !command.input.isEmpty() ) {
-        const QList<QString> availableFormats = data.keys();
-        if (command.input == mimeItems) {
-            // Disallow applying action that takes serialized item more times.
-            if ( availableFormats.contains(command.output) )
-                return false;
-        } else if ( !availableFormats.contains(command.input) ) {
-            return false;
-        }
-    }
-
-    // Verify that text is present when regex is defined.
-    if ( !command.re.isEmpty() && !data.contains(mimeText) )
-        return false;
-
-    // Verify that and text, MIME type and window title are matched.
-    const QString text = getTextData(data);
-    const QString windowTitle = data.value(mimeWindowTitle).toString();
-    if ( command.re.indexIn(text) == -1 || command.wndre.indexIn(windowTitle) == -1 )
-        return false;
-
-    return true;
-}
-
 bool hasFormat(const QVariantMap &data, const QString &format)
 {
     if (format == mimeItems) {
@@ -206,6 +172,39 @@ QMenu *createSubMenus(QString *name, QMenu *menu)
     return parentMenu;
 }
 
+/**
+ * Return true if automatic command must not run concurrently with other commands.
+ *
+ * Such command can ignore clipboard (cancel following commands) or it
+ * runs copyq (anywhere in command line) which can change application state.
+ */
+bool isSequentialCommand(const Command &command)
+{
+    return command.remove || command.transform || command.cmd.contains( QRegExp("\\bcopyq\\b") );
+}
+
+/// Return tabs to which command adds items (output or copy of clipboard).
+QStringList commandOutputTabs(const Command &command)
+{
+    QStringList tabs;
+    if ( !command.output.isEmpty() )
+        tabs.append(command.outputTab);
+    if ( !command.tab.isEmpty() )
+        tabs.append(command.tab);
+    return tabs;
+}
+
+/// Return true if both commands add items to same tab (order of items matters).
+bool haveSameOutputTab(const Command &command1, const Command &command2)
+{
+    const QStringList tabs2 = commandOutputTabs(command2);
+    foreach ( const QString &tab, commandOutputTabs(command1) ) {
+        if ( tabs2.contains(tab) )
+            return true;
+    }
+    return false;
+}
+
 Command automaticCommand(const QString &name, const QString &cmd)
 {
     Command c;
@@ -254,6 +253,7 @@ MainWindow::MainWindow(QWidget *parent)
     , m_actionHandler(new ActionHandler(this))
     , m_trayTab(NULL)
     , m_commandDialog(NULL)
+    , m_startAutomaticCommandTester(false)
     , m_canUpdateTitleFromScript(true)
 {
     ui->setupUi(this);
@@ -301,7 +301,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(&m_automaticCommandTester, SIGNAL(commandPassed(Command,bool)),
             SLOT(automaticCommandTestFinished(Command,bool)));
 
-    m_commands = loadCommands();
+    setCommands( loadCommands() );
     loadSettings();
 
     ui->tabWidget->setCurrentIndex(0);
@@ -572,9 +572,26 @@ void MainWindow::onAboutToQuit()
     m_trayMenuCommandTester.abort();
 }
 
+void MainWindow::setCommands(const QList<Command> &commands)
+{
+    m_commands = commands;
+
+    QList<Command> automaticCommands;
+    QList<Command> menuCommands;
+    foreach (const Command &command, commands) {
+        if (command.automatic)
+            automaticCommands.append(command);
+        if ( command.inMenu && !command.name.isEmpty() )
+            menuCommands.append(command);
+    }
+
+    m_automaticCommandMatcher.setCommands(automaticCommands);
+    m_menuCommandMatcher.setCommands(menuCommands);
+}
+
 void MainWindow::onCommandDialogSaved()
 {
-    m_commands = loadCommands();
+    setCommands( loadCommands() );
     updateContextMenu();
     emit commandsSaved();
 }
@@ -674,25 +691,43 @@ void MainWindow::automaticCommandTestFinished(const Command &command, bool passe
         return;
 
     m_automaticCommands.append(command);
-
-    if (!m_currentAutomaticCommand)
-        runNextAutomaticCommand();
+    startAutomaticCommands();
 }
 
-void MainWindow::automaticCommandFinished()
+void MainWindow::automaticCommandFinished(QObject *action)
 {
-    Q_ASSERT(!m_currentAutomaticCommand);
-
-    if (!m_automaticCommands.isEmpty()) {
-        const Command command = m_automaticCommands.takeFirst();
-        if (command.remove || command.transform) {
-            m_automaticCommands.clear();
-            COPYQ_LOG("Clipboard ignored by \"" + command.name + "\"");
+    for (int i = 0; i < m_runningAutomaticCommands.size(); ++i) {
+        if (m_runningAutomaticCommands[i].action == action) {
+            const RunningAutomaticCommand running = m_runningAutomaticCommands.takeAt(i);
+            const Command &command = running.command;
+            if ( !running.aborted && (command.remove || command.transform) ) {
+                m_automaticCommands.clear();
+                COPYQ_LOG("Clipboard ignored by \"" + command.name + "\"");
+            }
+            break;
         }
     }
 
-    if (!m_automaticCommands.isEmpty())
-        runNextAutomaticCommand();
+    if ( m_startAutomaticCommandTester && m_runningAutomaticCommands.isEmpty() ) {
+        m_startAutomaticCommandTester = false;
+        m_automaticCommandTester.start();
+    }
+
+    startAutomaticCommands();
+}
+
+void MainWindow::onItemsInserted(const QModelIndex &, int first, int last)
+{
+    const ClipboardModel *model = qobject_cast<const ClipboardModel*>(sender());
+    if (model && !model->isLoading())
+        emit itemsAdded(model->tabName(), first, last - first + 1);
+}
+
+void MainWindow::onItemsRemoved(const QModelIndex &, int first, int last)
+{
+    const ClipboardModel *model = qobject_cast<const ClipboardModel*>(sender());
+    if (model && !model->isUnloading())
+        emit itemsRemoved(model->tabName(), first, last - first + 1);
 }
 
 void MainWindow::enableActionForCommand(QMenu *menu, const Command &command, bool enable)
@@ -875,6 +910,10 @@ ClipboardBrowser *MainWindow::createTab(const QString &name, bool *needSave)
              this, SLOT(showContextMenu(QPoint)) );
     connect( c, SIGNAL(updateContextMenu()),
              this, SLOT(updateContextMenu()) );
+    connect( c->model(), SIGNAL(rowsInserted(QModelIndex,int,int)),
+             this, SLOT(onItemsInserted(QModelIndex,int,int)) );
+    connect( c->model(), SIGNAL(rowsRemoved(QModelIndex,int,int)),
+             this, SLOT(onItemsRemoved(QModelIndex,int,int)) );
 
     ui->tabWidget->addTab(c, name);
 
@@ -926,17 +965,15 @@ void MainWindow::addCommandsToMenu(QMenu *menu, const QVariantMap &data)
 
     QList<Command> disabledCommands;
     QList<Command> commands;
-    foreach (const Command &command, m_commands) {
-        if ( command.inMenu && !command.name.isEmpty() && canExecuteCommand(command, data, tabName) ) {
-            Command cmd = command;
-            if ( cmd.outputTab.isEmpty() )
-                cmd.outputTab = tabName;
-
-            bool enabled = cmd.matchCmd.isEmpty();
-            if (!enabled)
-                disabledCommands.append(cmd);
-            commands.append(cmd);
-        }
+    foreach ( int i, m_menuCommandMatcher.match(data, tabName) ) {
+        Command cmd = m_menuCommandMatcher.commands()[i];
+        if ( cmd.outputTab.isEmpty() )
+            cmd.outputTab = tabName;
+
+        bool enabled = cmd.matchCmd.isEmpty();
+        if (!enabled)
+            disabledCommands.append(cmd);
+        commands.append(cmd);
     }
 
     CommandAction::Type type = (menu == m_menuItem)
@@ -1073,29 +1110,53 @@ void MainWindow::initTray()
     }
 }
 
-void MainWindow::runNextAutomaticCommand()
+void MainWindow::startAutomaticCommands()
 {
-    Q_ASSERT(!m_automaticCommands.isEmpty());
-    Q_ASSERT(!m_currentAutomaticCommand);
+    const QVariantMap &data = m_automaticCommandTester.data();
 
-    const Command &command = m_automaticCommands.first();
+    // Commands are started in order; copying to tabs doesn't wait for anything.
+    while ( !m_automaticCommands.isEmpty() && canStartAutomaticCommand(m_automaticCommands.first()) ) {
+        const Command command = m_automaticCommands.takeFirst();
 
-    const QVariantMap &data = m_automaticCommandTester.data();
+        Action *act = NULL;
+        if ( command.input.isEmpty()
+             || command.input == mimeItems
+             || data.contains(command.input) )
+        {
+            act = action(data, command);
+        }
+
+        if (!command.tab.isEmpty())
+            addToTab(data, command.tab);
 
-    if ( command.input.isEmpty()
-         || command.input == mimeItems
-         || data.contains(command.input) )
-    {
-        m_currentAutomaticCommand = action(data, command);
+        if (act) {
+            const RunningAutomaticCommand running = { act, command, false };
+            m_runningAutomaticCommands.append(running);
+            connect(act, SIGNAL(destroyed(QObject*)), SLOT(automaticCommandFinished(QObject*)));
+        } else if (command.remove || command.transform) {
+            m_automaticCommands.clear();
+            COPYQ_LOG("Clipboard ignored by \"" + command.name + "\"");
+        }
     }
+}
+
+bool MainWindow::canStartAutomaticCommand(const Command &command) const
+{
+    if ( m_startAutomaticCommandTester )
+        return false;
 
-    if (!command.tab.isEmpty())
-        addToTab(data, command.tab);
+    if ( m_runningAutomaticCommands.isEmpty() )
+        return true;
 
-    if (m_currentAutomaticCommand)
-        connect(m_currentAutomaticCommand, SIGNAL(destroyed()), SLOT(automaticCommandFinished()));
-    else
-        automaticCommandFinished();
+    if ( isSequentialCommand(command) )
+        return false;
+
+    foreach (const RunningAutomaticCommand &running, m_runningAutomaticCommands) {
+        if ( isSequentialCommand(running.command) || haveSameOutputTab(command, running.command) )
+            return false;
+    }
+
+    return true;
 }
 
 bool MainWindow::isWindowVisible() const
@@ -1773,12 +1834,10 @@ void MainWindow::runAutomaticCommands(const QVariantMap &data)
 {
     QList<Command> commands;
     const QString tabName = cm->defaultTabName();
-    foreach (const Command &command, m_commands) {
-        if (command.automatic && canExecuteCommand(command, data, tabName)) {
-            commands.append(command);
-            if ( command.outputTab.isEmpty() )
-                commands.last().outputTab = tabName;
-        }
+    foreach ( int i, m_automaticCommandMatcher.match(data, tabName) ) {
+        commands.append( m_automaticCommandMatcher.commands()[i] );
+        if ( commands.last().outputTab.isEmpty() )
+            commands.last().outputTab = tabName;
     }
 
     // Clear window title and tooltip.
@@ -1793,12 +1852,11 @@ void MainWindow::runAutomaticCommands(const QVariantMap &data)
     abortAutomaticCommands();
     m_automaticCommandTester.setCommands(commands, data);
 
-    if (m_currentAutomaticCommand) {
-        connect(m_currentAutomaticCommand, SIGNAL(destroyed()),
-                &m_automaticCommandTester, SLOT(start()), Qt::UniqueConnection);
-    } else {
+    // Wait for commands for previous clipboard to finish.
+    if ( m_runningAutomaticCommands.isEmpty() )
         m_automaticCommandTester.start();
-    }
+    else
+        m_startAutomaticCommandTester = true;
 }
 
 void MainWindow::nextTab()
@@ -1899,11 +1957,14 @@ void MainWindow::abortAutomaticCommands()
 {
     m_automaticCommands.clear();
     m_automaticCommandTester.abort();
+    m_startAutomaticCommandTester = false;
 
-    if (m_currentAutomaticCommand) {
-        COPYQ_LOG("Aborting automatic commands (current is \"" + m_currentAutomaticCommand->name() + "\")");
-        disconnect(m_currentAutomaticCommand, SIGNAL(destroyed()),
-                   this, SLOT(automaticCommandFinished()));
+    for (int i = 0; i < m_runningAutomaticCommands.size(); ++i) {
+        RunningAutomaticCommand &running = m_runningAutomaticCommands[i];
+        if (!running.aborted) {
+            COPYQ_LOG("Aborting automatic commands (running \"" + running.command.name + "\")");
+            running.aborted = true;
+        }
     }
 }
 
@@ -2211,13 +2272,12 @@ bool MainWindow::saveTab(const QString &fileName, int tab_index)
         return false;
 
     QDataStream out(&file);
-    out.setVersion(QDataStream::Qt_4_7);
 
     int i = tab_index >= 0 ? tab_index : ui->tabWidget->currentIndex();
     ClipboardBrowser *c = browser(i);
     ClipboardModel *model = static_cast<ClipboardModel *>( c->model() );
 
-    out << QByteArray("CopyQ v2") << c->tabName();
+    serializeTabHeader(&out, c->tabName());
     serializeData(*model, &out);
 
     file.close();
@@ -2259,10 +2319,8 @@ bool MainWindow::loadTab(const QString &fileName)
 
     QDataStream in(&file);
 
-    QByteArray header;
     QString tabName;
-    in >> header >> tabName;
-    if ( !(header.startsWith("CopyQ v1") || header.startsWith("CopyQ v2")) || tabName.isEmpty() ) {
+    if ( !deserializeTabHeader(&in, &tabName) ) {
         file.close();
         return false;
     }
@@ -2346,6 +2404,7 @@ Action *MainWindow::action(const QVariantMap &data, const Command &cmd, const QM
         act->setItemSeparator(QRegExp(cmd.sep));
         act->setOutputTab(cmd.outputTab);
         act->setIndex(outputIndex);
+        act->setCoprocess(cmd.coprocess);
         act->setName(cmd.name);
         act->setData(data);
         m_actionHandler->action(act);
@@ -2429,10 +2488,12 @@ void MainWindow::renameTab(const QString &name, int tabIndex)
 
     ClipboardBrowser *c = getBrowser(tabIndex);
     if (c) {
-        updateTabIcon(name, c->tabName());
+        const QString oldName = c->tabName();
+        updateTabIcon(name, oldName);
         c->setTabName(name);
         ui->tabWidget->setTabText(tabIndex, name);
         saveTabPositions();
+        emit tabRenamed(name, oldName);
     }
 }
 
@@ -20,6 +20,7 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "common/commandmatcher.h"
 #include "common/commandtester.h"
 #include "gui/clipboardbrowser.h"
 #include "gui/configtabshortcuts.h"
@@ -390,6 +391,14 @@ signals:
     void stopItemMenuCommandTester();
     void stopTrayMenuCommandTester();
 
+    /** Items were added to a tab. */
+    void itemsAdded(const QString &tabName, int row, int count);
+
+    /** Items were removed from a tab (not emitted when tab is unloaded). */
+    void itemsRemoved(const QString &tabName, int row, int count);
+
+    void tabRenamed(const QString &newName, const QString &oldName);
+
 protected:
     void keyPressEvent(QKeyEvent *event);
     void keyReleaseEvent(QKeyEvent *event);
@@ -456,7 +465,10 @@ private slots:
     void action();
 
     void automaticCommandTestFinished(const Command &command, bool passed);
-    void automaticCommandFinished();
+    void automaticCommandFinished(QObject *action);
+
+    void onItemsInserted(const QModelIndex &parent, int first, int last);
+    void onItemsRemoved(const QModelIndex &parent, int first, int last);
 
     void enableActionForCommand(QMenu *menu, const Command &command, bool enable);
     void addCommandsToItemMenu(const Command &command, bool enable);
@@ -465,6 +477,9 @@ private slots:
 private:
     void clearTitle() { updateTitle(QVariantMap()); }
 
+    /** Set commands and compile matchers for automatic and menu commands. */
+    void setCommands(const QList<Command> &commands);
+
     /** Create menu bar and tray menu with items. Called once. */
     void createMenu();
 
@@ -524,7 +539,10 @@ private:
 
     void initTray();
 
-    void runNextAutomaticCommand();
+    /// Start queued automatic commands which don't depend on running ones.
+    void startAutomaticCommands();
+
+    bool canStartAutomaticCommand(const Command &command) const;
 
     bool isWindowVisible() const;
 
@@ -545,6 +563,8 @@ private:
 
     ClipboardBrowserSharedPtr m_sharedData;
     QList<Command> m_commands;
+    CommandMatcher m_automaticCommandMatcher;
+    CommandMatcher m_menuCommandMatcher;
 
     PlatformWindowPtr m_lastWindow;
 
@@ -571,8 +591,15 @@ private:
     CommandTester m_trayMenuCommandTester;
     CommandTester m_automaticCommandTester;
 
+    struct RunningAutomaticCommand {
+        QObject *action;
+        Command command;
+        bool aborted; ///< Command for previous clipboard.
+    };
+
     QList<Command> m_automaticCommands;
-    QPointer<Action> m_currentAutomaticCommand;
+    QList<RunningAutomaticCommand> m_runningAutomaticCommands;
+    bool m_startAutomaticCommandTester;
     bool m_canUpdateTitleFromScript;
 };
 
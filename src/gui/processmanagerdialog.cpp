@@ -26,6 +26,7 @@
 #include "gui/iconfont.h"
 #include "gui/icons.h"
 
+#include <QColor>
 #include <QDateTime>
 #include <QPushButton>
 
@@ -47,6 +48,7 @@ enum {
     status,
     beginTime,
     endTime,
+    usage,
     count
 };
 }
@@ -64,6 +66,8 @@ QString columnText(int column)
         return ProcessManagerDialog::tr("Name");
     case tableCommandsColumns::status:
         return ProcessManagerDialog::tr("Status");
+    case tableCommandsColumns::usage:
+        return ProcessManagerDialog::tr("Usage");
     default:
         Q_ASSERT(false && "Undefined name for column!");
     }
@@ -76,6 +80,30 @@ QString currentTime()
     return QDateTime::currentDateTime().toString(Qt::SystemLocaleLongDate);
 }
 
+QString formatSize(qint64 bytes)
+{
+    if (bytes < 1024)
+        return ProcessManagerDialog::tr("%1 B").arg(bytes);
+    if (bytes < 1024 * 1024)
+        return ProcessManagerDialog::tr("%1 KiB").arg(bytes / 1024);
+    return ProcessManagerDialog::tr("%1 MiB").arg(bytes / (1024 * 1024));
+}
+
+QString formatSeconds(qint64 ms)
+{
+    return ProcessManagerDialog::tr("%1 s").arg(ms / 1000.0, 0, 'f', 2);
+}
+
+QString usageText(const ActionUsage &usage)
+{
+    return ProcessManagerDialog::tr("%1, CPU %2, memory %3, in %4, out %5")
+            .arg( formatSeconds(usage.wallTimeMs),
+                  formatSeconds(usage.cpuTimeMs),
+                  formatSize(usage.peakMemoryKb * 1024),
+                  formatSize(usage.bytesIn),
+                  formatSize(usage.bytesOut) );
+}
+
 class SortingGuard {
 public:
     explicit SortingGuard(QTableWidget *table) : m_table(table) { m_table->setSortingEnabled(false); }
@@ -159,7 +187,12 @@ void ProcessManagerDialog::actionFinished(Action *action)
     const int row = getRowForAction(action);
     Q_ASSERT(row != -1);
 
-    const QString status = action->actionFailed() ? tr("Failed") : tr("Finished");
+    QString status = action->actionFailed() ? tr("Failed") : tr("Finished");
+
+    const ActionUsage &usage = action->usage();
+    const bool slow = ActionStatistics::isSlow(usage);
+    if (slow)
+        status = tr("%1 (slow)", "Status of command which took long time").arg(status);
 
     QTableWidget *t = ui->tableWidgetCommands;
     SortingGuard sortGuard(t);
@@ -169,6 +202,10 @@ void ProcessManagerDialog::actionFinished(Action *action)
     statusItem->setText(status);
     statusItem->setData(statusItemData::status, QProcess::NotRunning);
     t->item(row, tableCommandsColumns::endTime)->setText(currentTime());
+    QTableWidgetItem *usageItem = t->item(row, tableCommandsColumns::usage);
+    usageItem->setText( usageText(usage) );
+    if (slow)
+        usageItem->setForeground( QColor(Qt::red) );
     button->setToolTip( tr("Remove") );
     button->setProperty( "text", QString(IconRemove) );
     updateTable();
@@ -273,6 +310,7 @@ void ProcessManagerDialog::createTableRow(const QString &name, Action *action)
     t->setItem( 0, tableCommandsColumns::beginTime, new QTableWidgetItem(currentTime()) );
     t->setItem( 0, tableCommandsColumns::endTime, new QTableWidgetItem(
                     action ? QString() : currentTime()) );
+    t->setItem( 0, tableCommandsColumns::usage, new QTableWidgetItem() );
     t->setCellWidget( 0, tableCommandsColumns::action, createRemoveButton(action) );
     updateTable();
 }
@@ -51,13 +51,59 @@ int topMostRow(const QList<QPersistentModelIndex> &indexList)
 
 } // namespace
 
+ClipboardModelSnapshot::ClipboardModelSnapshot(
+        const ClipboardItemList &items, int version,
+        const QSharedPointer<QAtomicInt> &modelVersion)
+    : m_items(items)
+    , m_version(version)
+    , m_modelVersion(modelVersion)
+{
+}
+
+QVariantMap ClipboardModelSnapshot::itemData(int row) const
+{
+    if (row < 0 || row >= m_items.size())
+        return QVariantMap();
+
+    return m_items[row].data(contentType::data).toMap();
+}
+
+bool ClipboardModelSnapshot::isValid() const
+{
+    return m_modelVersion->fetchAndAddOrdered(0) == m_version;
+}
+
 ClipboardModel::ClipboardModel(QObject *parent)
     : QAbstractListModel(parent)
     , m_max(100)
     , m_clipboardList(m_max)
     , m_disabled(false)
+    , m_unloading(false)
+    , m_loading(false)
     , m_tabName()
+    , m_version(new QAtomicInt(0))
+    , m_snapshot()
 {
+    connect( this, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             this, SLOT(invalidateSnapshot()) );
+    connect( this, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+             this, SLOT(invalidateSnapshot()) );
+    connect( this, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+             this, SLOT(invalidateSnapshot()) );
+    connect( this, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+             this, SLOT(invalidateSnapshot()) );
+    connect( this, SIGNAL(layoutChanged()),
+             this, SLOT(invalidateSnapshot()) );
+    connect( this, SIGNAL(modelReset()),
+             this, SLOT(invalidateSnapshot()) );
+    connect( this, SIGNAL(tabNameChanged(QString)),
+             this, SLOT(invalidateSnapshot()) );
+}
+
+ClipboardModel::~ClipboardModel()
+{
+    // Snapshots of removed model are no longer valid.
+    invalidateSnapshot();
 }
 
 int ClipboardModel::rowCount(const QModelIndex&) const
@@ -128,6 +174,22 @@ void ClipboardModel::insertItem(const QVariantMap &data, int row)
     endInsertRows();
 }
 
+void ClipboardModel::insertItems(const QList<QVariantMap> &dataList, int row)
+{
+    if ( dataList.isEmpty() )
+        return;
+
+    beginInsertRows(QModelIndex(), row, row + dataList.size() - 1);
+
+    for ( int i = dataList.size() - 1; i >= 0; --i ) {
+        ClipboardItem item;
+        item.setData(dataList[i]);
+        m_clipboardList.insert(row, item);
+    }
+
+    endInsertRows();
+}
+
 bool ClipboardModel::insertRows(int position, int rows, const QModelIndex&)
 {
     beginInsertRows(QModelIndex(), position, position + rows - 1);
@@ -174,7 +236,9 @@ int ClipboardModel::getRowNumber(int row, bool cycle) const
 void ClipboardModel::unloadItems()
 {
     emit unloaded();
+    m_unloading = true;
     removeRows(0, rowCount());
+    m_unloading = false;
 }
 
 void ClipboardModel::setMaxItems(int max)
@@ -296,6 +360,23 @@ void ClipboardModel::sortItems(const QModelIndexList &indexList, CompareItems *c
     }
 }
 
+ClipboardModelSnapshotPtr ClipboardModel::snapshot() const
+{
+    if (!m_snapshot) {
+        m_snapshot = ClipboardModelSnapshotPtr(
+                    new ClipboardModelSnapshot(
+                        m_clipboardList, m_version->fetchAndAddOrdered(0), m_version) );
+    }
+
+    return m_snapshot;
+}
+
+void ClipboardModel::invalidateSnapshot()
+{
+    m_version->ref();
+    m_snapshot.clear();
+}
+
 int ClipboardModel::findItem(uint item_hash) const
 {
     for (int i = 0; i < m_clipboardList.size(); ++i) {
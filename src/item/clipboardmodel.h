@@ -23,6 +23,9 @@
 #include "item/clipboarditem.h"
 
 #include <QAbstractListModel>
+#include <QAtomicInt>
+#include <QMetaType>
+#include <QSharedPointer>
 #include <QVector>
 
 /**
@@ -90,6 +93,36 @@ private:
     QVector<ClipboardItem> m_items;
 };
 
+/**
+ * Immutable copy of items in ClipboardModel.
+ *
+ * Snapshot can be read from any thread. It's cheap to create since items are
+ * implicitly shared with the model until the model changes.
+ */
+class ClipboardModelSnapshot {
+public:
+    ClipboardModelSnapshot(
+            const ClipboardItemList &items, int version,
+            const QSharedPointer<QAtomicInt> &modelVersion);
+
+    /** Return number of items. */
+    int size() const { return m_items.size(); }
+
+    /** Return data of item in @a row or empty map if there is no such item. */
+    QVariantMap itemData(int row) const;
+
+    /** Return true only if model hasn't changed since the snapshot was created. */
+    bool isValid() const;
+
+private:
+    ClipboardItemList m_items;
+    int m_version;
+    QSharedPointer<QAtomicInt> m_modelVersion;
+};
+
+typedef QSharedPointer<const ClipboardModelSnapshot> ClipboardModelSnapshotPtr;
+Q_DECLARE_METATYPE(ClipboardModelSnapshotPtr)
+
 /**
  * Model containing ClipboardItem objects.
  *
@@ -111,6 +144,8 @@ public:
 
     explicit ClipboardModel(QObject *parent = NULL);
 
+    ~ClipboardModel();
+
     /** Return number of items in model. */
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
 
@@ -130,6 +165,9 @@ public:
     /** insert new item to model. */
     void insertItem(const QVariantMap &data, int row);
 
+    /** Insert new items to model at once. */
+    void insertItems(const QList<QVariantMap> &dataList, int row);
+
     /**
      * Set maximum number of items in model.
      *
@@ -197,15 +235,37 @@ public:
     /** Emit unloaded() and unload (remove) all items. */
     void unloadItems();
 
+    /** Return true while items are being removed by unloadItems(). */
+    bool isUnloading() const { return m_unloading; }
+
+    /** Return true while stored items are being loaded. */
+    bool isLoading() const { return m_loading; }
+
+    void setLoading(bool loading) { m_loading = loading; }
+
+    /**
+     * Return snapshot of current items.
+     *
+     * New snapshot is created only if model changed since last call.
+     */
+    ClipboardModelSnapshotPtr snapshot() const;
+
 signals:
     void unloaded();
     void tabNameChanged(const QString &tabName);
 
+private slots:
+    void invalidateSnapshot();
+
 private:
     int m_max;
     ClipboardItemList m_clipboardList;
     bool m_disabled;
+    bool m_unloading;
+    bool m_loading;
     QString m_tabName;
+    QSharedPointer<QAtomicInt> m_version;
+    mutable ClipboardModelSnapshotPtr m_snapshot;
 };
 
 #endif // CLIPBOARDMODEL_H
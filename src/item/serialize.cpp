@@ -245,3 +245,22 @@ bool deserializeData(QAbstractItemModel *model, QFile *file)
     QDataStream stream(file);
     return deserializeData(model, &stream);
 }
+
+bool serializeTabHeader(QDataStream *stream, const QString &tabName)
+{
+    stream->setVersion(QDataStream::Qt_4_7);
+    *stream << QByteArray("CopyQ v2") << tabName;
+    return stream->status() == QDataStream::Ok;
+}
+
+bool deserializeTabHeader(QDataStream *stream, QString *tabName)
+{
+    stream->setVersion(QDataStream::Qt_4_7);
+
+    QByteArray header;
+    *stream >> header >> *tabName;
+
+    return stream->status() == QDataStream::Ok
+            && (header.startsWith("CopyQ v1") || header.startsWith("CopyQ v2"))
+            && !tabName->isEmpty();
+}
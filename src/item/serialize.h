@@ -26,6 +26,7 @@ class QAbstractItemModel;
 class QByteArray;
 class QDataStream;
 class QFile;
+class QString;
 
 void serializeData(QDataStream *out, const QVariantMap &data);
 void deserializeData(QDataStream *stream, QVariantMap *data);
@@ -37,4 +38,9 @@ bool deserializeData(QAbstractItemModel *model, QDataStream *stream);
 bool serializeData(const QAbstractItemModel &model, QFile *file);
 bool deserializeData(QAbstractItemModel *model, QFile *file);
 
+/** Write header of file with exported tab (items follow as serialized model). */
+bool serializeTabHeader(QDataStream *stream, const QString &tabName);
+/** Read header of file with exported tab, return false if the file is invalid. */
+bool deserializeTabHeader(QDataStream *stream, QString *tabName);
+
 #endif // SERIALIZE_H
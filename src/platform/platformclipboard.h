@@ -45,6 +45,10 @@ public:
      *   - "check_selection" (bool) - emit changed() when X11 selection changes
      *   - "formats" (QStringList)  - string list with MIME formats to store
      *     (formats are also passed to data() method call from ClipboardMonitor)
+     *   - "change_delay" (int)     - milliseconds to wait for more changes
+     *     before reporting new clipboard content (handled by ClipboardMonitor)
+     *   - "max_change_rate" (int)  - maximum clipboard changes reported per second
+     *     (handled by ClipboardMonitor)
      */
     virtual void loadSettings(const QVariantMap &settings) = 0;
 
@@ -118,7 +118,9 @@ QList<CommandHelp> commandHelp()
                            Scriptable::tr("Set separator for items on output."))
                .addArg(Scriptable::tr("SEPARATOR"))
             << CommandHelp("read",
-                           Scriptable::tr("Print raw data of clipboard or item in row."))
+                           Scriptable::tr("Print raw data of clipboard or item in row.\n"
+                                          "MIME applies to following rows, row -1 is for clipboard.\n"
+                                          "Data of multiple rows are joined with separator."))
                .addArg("[" + Scriptable::tr("MIME") + "|" + Scriptable::tr("ROW") + "]...")
             << CommandHelp("write", Scriptable::tr("\nWrite raw data to given row."))
                .addArg("[" + Scriptable::tr("ROW") + "=0]")
@@ -160,8 +162,12 @@ QList<CommandHelp> commandHelp()
                            Scriptable::tr("Export items to file."))
                .addArg(Scriptable::tr("FILE_NAME"))
             << CommandHelp("importtab",
-                           Scriptable::tr("Import items from file."))
+                           Scriptable::tr("Import items from file to new tab."))
                .addArg(Scriptable::tr("FILE_NAME"))
+            << CommandHelp("importtab",
+                           Scriptable::tr("Import items from file to end of tab skipping items already in the tab."))
+               .addArg(Scriptable::tr("FILE_NAME"))
+               .addArg(Scriptable::tr("TAB_NAME"))
             << CommandHelp()
             << CommandHelp("config",
                            Scriptable::tr("List all options."))
@@ -178,6 +184,26 @@ QList<CommandHelp> commandHelp()
                                           "Arguments are accessible using with \"arguments(0..N)\"."))
                .addArg("[" + Scriptable::tr("SCRIPT") + "]")
                .addArg("[" + Scriptable::tr("ARGUMENTS") + "]...")
+            << CommandHelp("subscribe",
+                           Scriptable::tr("\nKeep running and print a line for each event:\n"
+                                          "clipboard FORMATS, added TAB ROW COUNT, removed TAB ROW COUNT,\n"
+                                          "renamed NEW_TAB OLD_TAB (all events if none is specified)."))
+               .addArg("[clipboard|added|removed|renamed]...")
+            << CommandHelp("commandqueue",
+                           Scriptable::tr("\nPrint number of queued and running commands and their latency."))
+            << CommandHelp("commandstats",
+                           Scriptable::tr("\nPrint resource usage of finished commands grouped by command name."))
+            << CommandHelp("monitorstats",
+                           Scriptable::tr("\nPrint number of clipboard changes merged or dropped by clipboard monitor."))
+            << CommandHelp("profile",
+                           Scriptable::tr("\nPrint command timing statistics (if profiling is enabled)\n"
+                                          "and number of evaluated scripts found in cache."))
+            << CommandHelp("profile",
+                           Scriptable::tr("Print command timing statistics in JSON format."))
+               .addArg("json")
+            << CommandHelp("profile",
+                           Scriptable::tr("Enable or disable profiling of commands or clear statistics."))
+               .addArg("enable|disable|reset")
             << CommandHelp("session, -s, --session",
                            Scriptable::tr("\nStarts or connects to application instance with given session name."))
                .addArg(Scriptable::tr("SESSION"))
@@ -20,18 +20,26 @@
 #include "scriptable.h"
 
 #include "common/action.h"
+#include "common/actionstatistics.h"
+#include "common/clipboardchangestatistics.h"
 #include "common/command.h"
 #include "common/commandstatus.h"
 #include "common/common.h"
+#include "common/log.h"
 #include "common/mimetypes.h"
 #include "item/serialize.h"
 #include "scriptable/commandhelp.h"
 #include "scriptable/dirclass.h"
 #include "scriptable/fileclass.h"
+#include "scriptable/scriptableprocess.h"
+#include "scriptable/scriptableprofiler.h"
+#include "scriptable/scriptableworkerpool.h"
 #include "../qt/bytearrayclass.h"
 #include "../qxt/qxtglobal.h"
 
 #include <QApplication>
+#include <QAtomicInt>
+#include <QDataStream>
 #include <QDateTime>
 #include <QDir>
 #include <QDesktopServices>
@@ -66,6 +74,12 @@ QString helpTail()
         + Scriptable::tr("  - Use ? for MIME to print available MIME types (default is \"text/plain\").");
 }
 
+/// Maximum number of compiled programs kept for each engine.
+const int maxCachedPrograms = 64;
+
+QAtomicInt programCacheHitCount(0);
+QAtomicInt programCacheMissCount(0);
+
 QString argumentError()
 {
     return Scriptable::tr("Invalid number of arguments!");
@@ -150,6 +164,106 @@ void addScriptableClass(QScriptValue *rootObject, ScriptableClass *cls)
     rootObject->setProperty( cls->name(), cls->constructor() );
 }
 
+/// Maximum number of items (or data size) imported in single call to GUI thread.
+const int importBatchItems = 100;
+const int importBatchBytes = 4 * 1024 * 1024;
+
+int itemDataSize(const QVariantMap &data)
+{
+    int size = 0;
+    foreach (const QVariant &value, data)
+        size += value.toByteArray().size();
+    return size;
+}
+
+/**
+ * Write items from snapshot of current tab to a file.
+ *
+ * Items are serialized in script thread so GUI is not blocked.
+ */
+bool exportItems(ScriptableProxy *proxy, const QString &fileName)
+{
+    const ClipboardModelSnapshotPtr items = proxy->browserSnapshot();
+    if (!items)
+        return false;
+
+    QFile file(fileName);
+    if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+        return false;
+
+    QDataStream out(&file);
+    serializeTabHeader( &out, proxy->currentTab() );
+
+    // Same format as serialized model.
+    const qint32 length = items->size();
+    out << length;
+
+    for (qint32 i = 0; i < length && out.status() == QDataStream::Ok; ++i)
+        serializeData( &out, items->itemData(i) );
+
+    COPYQ_LOG( QString("Exported %1 items to \"%2\"").arg(length).arg(fileName) );
+
+    return out.status() == QDataStream::Ok && file.error() == QFile::NoError;
+}
+
+/**
+ * Read items from file and add them to a tab in batches.
+ *
+ * If @a tabName is empty, items are added to new tab with name from file,
+ * otherwise items are added to given tab skipping items already in the tab.
+ */
+bool importItems(ScriptableProxy *proxy, const QString &fileName, const QString &tabName)
+{
+    QFile file(fileName);
+    if ( !file.open(QIODevice::ReadOnly) )
+        return false;
+
+    QDataStream in(&file);
+
+    QString fileTabName;
+    if ( !deserializeTabHeader(&in, &fileTabName) )
+        return false;
+
+    qint32 length;
+    in >> length;
+    if ( length < 0 || in.status() != QDataStream::Ok )
+        return false;
+
+    const bool merge = !tabName.isEmpty();
+    const QString targetTabName = merge ? tabName : proxy->createUniqueTab(fileTabName);
+    if ( targetTabName.isEmpty() )
+        return false;
+
+    QVariantList batch;
+    int batchBytes = 0;
+    int added = 0;
+
+    for (qint32 i = 0; i < length; ++i) {
+        QVariantMap data;
+        deserializeData(&in, &data);
+        if ( in.status() != QDataStream::Ok )
+            return false;
+
+        batchBytes += itemDataSize(data);
+        batch.append(data);
+
+        if ( i + 1 == length || batch.size() >= importBatchItems || batchBytes >= importBatchBytes ) {
+            const int batchAdded = proxy->browserAppendItems(targetTabName, batch, merge);
+            if (batchAdded < 0)
+                return false;
+
+            added += batchAdded;
+            COPYQ_LOG( QString("Importing \"%1\": %2/%3 items read, %4 added")
+                       .arg(fileName).arg(i + 1).arg(length).arg(added) );
+
+            batch.clear();
+            batchBytes = 0;
+        }
+    }
+
+    return true;
+}
+
 } // namespace
 
 Scriptable::Scriptable(ScriptableProxy *proxy, QObject *parent)
@@ -162,6 +276,8 @@ Scriptable::Scriptable(ScriptableProxy *proxy, QObject *parent)
     , m_fileClass(NULL)
     , m_inputSeparator("\n")
     , m_input()
+    , m_data()
+    , m_aborted(false)
 {
 }
 
@@ -202,6 +318,20 @@ void Scriptable::initEngine(
     addScriptableClass(&obj, m_dirClass);
 }
 
+void Scriptable::reset(
+        ScriptableProxy *proxy, const QString &currentPath, const QVariantMap &data)
+{
+    m_proxy = proxy;
+    m_data = data;
+    m_input = QScriptValue();
+    m_inputSeparator = "\n";
+    m_aborted = false;
+    setCurrentPath(currentPath);
+
+    // Kill processes started by previous command.
+    qDeleteAll( findChildren<ScriptableProcess*>() );
+}
+
 QScriptValue Scriptable::newByteArray(const QByteArray &bytes)
 {
     return m_baClass->newInstance(bytes);
@@ -225,7 +355,7 @@ QString Scriptable::toString(const QScriptValue &value) const
 {
     QByteArray *bytes = getByteArray(value);
     return (bytes == NULL) ? value.toString()
-                           : QString::fromUtf8( bytes->data() );
+                           : QString::fromUtf8( bytes->constData(), bytes->size() );
 }
 
 bool Scriptable::toInt(const QScriptValue &value, int &number) const
@@ -645,25 +775,36 @@ QScriptValue Scriptable::read()
     QByteArray result;
     QString mime(mimeText);
     QScriptValue value;
-    QString sep = getInputSeparator();
 
-    bool used = false;
+    QList<int> rows;
+    QStringList mimes;
     for ( int i = 0; i < argumentCount(); ++i ) {
         value = argument(i);
         int row;
         if ( toInt(value, row) ) {
-            if (used)
-                result.append(sep);
-            used = true;
-            result.append( row >= 0 ? m_proxy->browserItemData(row, mime)
-                                    : m_proxy->getClipboardData(mime) );
+            rows.append(row);
+            mimes.append(mime);
         } else {
             mime = toString(value);
         }
     }
 
-    if (!used)
+    if ( rows.isEmpty() ) {
         result.append( m_proxy->getClipboardData(mime) );
+    } else if ( rows.size() == 1 ) {
+        const int row = rows.first();
+        result.append( row >= 0 ? m_proxy->browserItemData(row, mime)
+                                : m_proxy->getClipboardData(mime) );
+    } else {
+        // Fetch all rows at once.
+        const QByteArray sep = getInputSeparator().toUtf8();
+        const QVariantList items = m_proxy->browserItemsData(rows, mimes);
+        for ( int i = 0; i < items.size(); ++i ) {
+            if (i > 0)
+                result.append(sep);
+            result.append( items[i].toByteArray() );
+        }
+    }
 
     return newByteArray(result);
 }
@@ -740,7 +881,7 @@ void Scriptable::exporttab()
     const QString &fileName = arg(0);
     if ( fileName.isNull() ) {
         throwError(argumentError());
-    } else if ( !m_proxy->saveTab(getFileName(fileName)) ) {
+    } else if ( !exportItems(m_proxy, getFileName(fileName)) ) {
         throwError( tr("Cannot save to file \"%1\"!").arg(fileName) );
     }
 }
@@ -750,7 +891,7 @@ void Scriptable::importtab()
     const QString &fileName = arg(0);
     if ( fileName.isNull() ) {
         throwError(argumentError());
-    } else if ( !m_proxy->loadTab(getFileName(fileName)) ) {
+    } else if ( !importItems(m_proxy, getFileName(fileName), arg(1)) ) {
         throwError(
             tr("Cannot import file \"%1\"!").arg(fileName) );
     }
@@ -774,16 +915,49 @@ QScriptValue Scriptable::eval()
 {
     const QString script = arg(0);
 
-    const QScriptSyntaxCheckResult syntaxResult = engine()->checkSyntax(script);
-    if (syntaxResult.state() != QScriptSyntaxCheckResult::Valid) {
-        throwError( QString("Eval:%1:%2: syntax error: %3")
-                    .arg(syntaxResult.errorLineNumber())
-                    .arg(syntaxResult.errorColumnNumber())
-                    .arg(syntaxResult.errorMessage()) );
-        return QScriptValue();
+    QScriptProgram program = m_programs.value(script);
+
+    if ( program.isNull() ) {
+        const QScriptSyntaxCheckResult syntaxResult = engine()->checkSyntax(script);
+        if (syntaxResult.state() != QScriptSyntaxCheckResult::Valid) {
+            throwError( QString("Eval:%1:%2: syntax error: %3")
+                        .arg(syntaxResult.errorLineNumber())
+                        .arg(syntaxResult.errorColumnNumber())
+                        .arg(syntaxResult.errorMessage()) );
+            return QScriptValue();
+        }
+
+        if (m_programs.size() >= maxCachedPrograms)
+            m_programs.clear();
+
+        program = QScriptProgram(script);
+        m_programs.insert(script, program);
+
+        const int misses = programCacheMissCount.fetchAndAddRelaxed(1) + 1;
+        COPYQ_LOG( QString("Script cache: miss (hits: %1, misses: %2)")
+                   .arg(programCacheHits()).arg(misses) );
+    } else {
+        programCacheHitCount.ref();
     }
 
-    return engine()->evaluate(script);
+    return engine()->evaluate(program);
+}
+
+void Scriptable::resetProfile()
+{
+    ScriptableProfiler::reset();
+    programCacheHitCount.fetchAndStoreRelaxed(0);
+    programCacheMissCount.fetchAndStoreRelaxed(0);
+}
+
+int Scriptable::programCacheHits()
+{
+    return programCacheHitCount.fetchAndAddRelaxed(0);
+}
+
+int Scriptable::programCacheMisses()
+{
+    return programCacheMissCount.fetchAndAddRelaxed(0);
 }
 
 QScriptValue Scriptable::currentpath()
@@ -826,6 +1000,7 @@ void Scriptable::abort()
     if (eng == NULL)
         eng = m_engine;
     if ( eng && eng->isEvaluating() ) {
+        m_aborted = true;
         setInput(QByteArray()); // stop waiting for input
         eng->abortEvaluation();
     }
@@ -927,6 +1102,20 @@ QScriptValue Scriptable::pack()
 
 QScriptValue Scriptable::getitem()
 {
+    if (argumentCount() > 1) {
+        const QList<int> rows = getRows();
+        if ( rows.size() != argumentCount() ) {
+            throwError(argumentError());
+            return QScriptValue();
+        }
+
+        QList<QVariantMap> items;
+        foreach ( const QVariant &item, m_proxy->browserItemsData(rows) )
+            items.append( item.toMap() );
+
+        return toScriptValue(items, this);
+    }
+
     int row;
     if ( !toInt(argument(0), row) ) {
         throwError(argumentError());
@@ -980,9 +1169,14 @@ QScriptValue Scriptable::execute()
         args.append(toString(arg));
     }
 
-    Action action;
+    QByteArray input;
     for ( ++i ; i < argumentCount(); ++i )
-        action.setInput( action.input() + makeByteArray(argument(i)) );
+        input.append( makeByteArray(argument(i)) );
+
+    const ScriptableProfiler::Timer timer("process");
+
+    Action action;
+    action.setInput(input);
 
     action.setCommand(args);
     action.setOutputFormat("DATA");
@@ -995,6 +1189,8 @@ QScriptValue Scriptable::execute()
 
     if ( action.isRunning() && !action.waitForFinished(5000) ) {
         action.terminate();
+        if ( !action.waitForFinished(5000) )
+            action.kill();
         return QScriptValue();
     }
 
@@ -1009,6 +1205,66 @@ QScriptValue Scriptable::execute()
     return actionResult;
 }
 
+QScriptValue Scriptable::startProcess()
+{
+    QStringList args;
+    for ( int i = 0; i < argumentCount(); ++i )
+        args.append( toString(argument(i)) );
+
+    ScriptableProcess *process = new ScriptableProcess(this);
+    if ( !process->start(args) ) {
+        delete process;
+        return QScriptValue();
+    }
+
+    const QScriptEngine::QObjectWrapOptions opts =
+              QScriptEngine::ExcludeSuperClassContents
+            | QScriptEngine::ExcludeDeleteLater;
+
+    return m_engine->newQObject(process, QScriptEngine::QtOwnership, opts);
+}
+
+QScriptValue Scriptable::commandqueue()
+{
+    return ScriptableWorkerPool::statistics();
+}
+
+QScriptValue Scriptable::commandstats()
+{
+    return ActionStatistics::statistics();
+}
+
+QScriptValue Scriptable::monitorstats()
+{
+    return ClipboardChangeStatistics::statistics();
+}
+
+QScriptValue Scriptable::profile()
+{
+    const QString command = arg(0);
+
+    if ( command.isEmpty() ) {
+        return ScriptableProfiler::statistics()
+                + QString("%1 %2\n%3 %4\n")
+                  .arg("program_cache.hits", -32).arg(programCacheHits(), 7)
+                  .arg("program_cache.misses", -32).arg(programCacheMisses(), 7);
+    }
+
+    if (command == "json")
+        return ScriptableProfiler::statisticsJson();
+
+    if (command == "enable")
+        ScriptableProfiler::setEnabled(true);
+    else if (command == "disable")
+        ScriptableProfiler::setEnabled(false);
+    else if (command == "reset")
+        resetProfile();
+    else
+        throwError(argumentError());
+
+    return QScriptValue();
+}
+
 QScriptValue Scriptable::currentWindowTitle()
 {
     return m_proxy->currentWindowTitle();
@@ -22,9 +22,11 @@
 
 #include "scriptableproxy.h"
 
+#include <QHash>
 #include <QObject>
 #include <QString>
 #include <QScriptable>
+#include <QScriptProgram>
 #include <QScriptValue>
 
 class ByteArrayClass;
@@ -46,6 +48,11 @@ public:
     void initEngine(
             QScriptEngine *engine, const QString &currentPath, const QVariantMap &data);
 
+    /**
+     * Prepare for running new command in engine already initialized with initEngine().
+     */
+    void reset(ScriptableProxy *proxy, const QString &currentPath, const QVariantMap &data);
+
     QScriptValue newByteArray(const QByteArray &bytes);
 
     QScriptValue newVariant(const QVariant &value);
@@ -93,6 +100,18 @@ public:
 
     QScriptEngine *engine() const { return m_engine; }
 
+    /** Return true if current command was aborted (e.g. client disconnected). */
+    bool isAborted() const { return m_aborted; }
+
+    /** Number of scripts evaluated without parsing (in all threads). */
+    static int programCacheHits();
+
+    /** Number of scripts that had to be parsed (in all threads). */
+    static int programCacheMisses();
+
+    /** Clear profiling statistics and script cache hit and miss counts. */
+    static void resetProfile();
+
 public slots:
     QScriptValue version();
     QScriptValue help();
@@ -181,6 +200,15 @@ public slots:
 
     QScriptValue open();
     QScriptValue execute();
+    QScriptValue startProcess();
+
+    QScriptValue commandqueue();
+
+    QScriptValue commandstats();
+
+    QScriptValue monitorstats();
+
+    QScriptValue profile();
 
     QScriptValue currentWindowTitle();
 
@@ -214,6 +242,10 @@ private:
     QString m_inputSeparator;
     QScriptValue m_input;
     QVariantMap m_data;
+    bool m_aborted;
+
+    /// Compiled scripts for eval() (engine caches compiled code of each program).
+    QHash<QString, QScriptProgram> m_programs;
 };
 
 #endif // SCRIPTABLE_H
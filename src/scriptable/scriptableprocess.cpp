@@ -0,0 +1,144 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scriptableprocess.h"
+
+#include "common/action.h"
+#include "scriptable/scriptable.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+
+namespace {
+
+/// Interval (in ms) to wait for process before checking if script was aborted.
+const int waitIntervalMs = 100;
+
+} // namespace
+
+ScriptableProcess::ScriptableProcess(Scriptable *scriptable)
+    : QObject(scriptable)
+    , m_scriptable(scriptable)
+    , m_process(new QProcess(this))
+{
+}
+
+bool ScriptableProcess::start(const QStringList &arguments)
+{
+    if ( arguments.isEmpty() )
+        return false;
+
+    m_process->setProcessEnvironment( Action::processEnvironment() );
+    Action::startProcess(m_process, arguments);
+    return m_process->waitForStarted(5000);
+}
+
+int ScriptableProcess::exitCode() const
+{
+    return m_process->exitCode();
+}
+
+bool ScriptableProcess::isRunning() const
+{
+    return m_process->state() != QProcess::NotRunning;
+}
+
+bool ScriptableProcess::write(const QScriptValue &value)
+{
+    if ( m_process->write(m_scriptable->makeByteArray(value)) == -1 )
+        return false;
+
+    // Don't buffer more input if process is not reading it.
+    while ( m_process->bytesToWrite() > 0 ) {
+        if ( !isRunning() || !canWait() )
+            return false;
+        m_process->waitForBytesWritten(waitIntervalMs);
+    }
+
+    return true;
+}
+
+void ScriptableProcess::closeInput()
+{
+    m_process->closeWriteChannel();
+}
+
+QScriptValue ScriptableProcess::read()
+{
+    if ( !waitForOutput(false) )
+        return QScriptValue();
+
+    return m_scriptable->newByteArray( m_process->readAllStandardOutput() );
+}
+
+QScriptValue ScriptableProcess::readLine()
+{
+    if ( !waitForOutput(true) )
+        return QScriptValue();
+
+    return m_scriptable->newByteArray( m_process->readLine() );
+}
+
+QScriptValue ScriptableProcess::readError()
+{
+    return m_scriptable->newByteArray( m_process->readAllStandardError() );
+}
+
+QScriptValue ScriptableProcess::wait(int msecs)
+{
+    QElapsedTimer t;
+    t.start();
+
+    while ( isRunning() ) {
+        const int remainingMs = msecs < 0 ? waitIntervalMs : msecs - static_cast<int>(t.elapsed());
+        if ( remainingMs <= 0 || !canWait() )
+            return QScriptValue();
+        m_process->waitForFinished( qMin(waitIntervalMs, remainingMs) );
+    }
+
+    return exitCode();
+}
+
+void ScriptableProcess::kill()
+{
+    if ( isRunning() ) {
+        m_process->kill();
+        while ( isRunning() && canWait() )
+            m_process->waitForFinished(waitIntervalMs);
+    }
+}
+
+bool ScriptableProcess::waitForOutput(bool wholeLine)
+{
+    while ( wholeLine ? !m_process->canReadLine() : m_process->bytesAvailable() == 0 ) {
+        if ( !isRunning() || !canWait() )
+            break;
+        m_process->waitForReadyRead(waitIntervalMs);
+    }
+
+    return m_process->bytesAvailable() > 0;
+}
+
+bool ScriptableProcess::canWait()
+{
+    // Abort is requested from the script thread event loop.
+    QCoreApplication::processEvents();
+    return !m_scriptable->isAborted();
+}
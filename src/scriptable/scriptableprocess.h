@@ -0,0 +1,91 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCRIPTABLEPROCESS_H
+#define SCRIPTABLEPROCESS_H
+
+#include <QObject>
+#include <QScriptValue>
+#include <QStringList>
+
+class QProcess;
+class Scriptable;
+
+/**
+ * Process started from script with streamed standard input and output.
+ *
+ * Methods block only the thread running the script and return early if the
+ * script is aborted. Standard output can be read in chunks or lines so large
+ * data don't need to be kept in memory and multiple processes can run at the
+ * same time. Standard error output is buffered while waiting for the process
+ * so the process cannot block on writing it.
+ *
+ * Object is deleted with the parent Scriptable or when Scriptable is reset
+ * for next command.
+ */
+class ScriptableProcess : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int exit_code READ exitCode)
+    Q_PROPERTY(bool running READ isRunning)
+
+public:
+    explicit ScriptableProcess(Scriptable *scriptable);
+
+    /** Start program (first argument) with arguments and wait for it to start. */
+    bool start(const QStringList &arguments);
+
+    int exitCode() const;
+
+    bool isRunning() const;
+
+public slots:
+    /** Write data to standard input and wait until written. */
+    bool write(const QScriptValue &value);
+
+    /** Close standard input of process. */
+    void closeInput();
+
+    /** Return next chunk of standard output or undefined if process finished. */
+    QScriptValue read();
+
+    /** Return next line of standard output or undefined if process finished. */
+    QScriptValue readLine();
+
+    /** Return standard error output read so far. */
+    QScriptValue readError();
+
+    /** Wait for process to finish and return exit code or undefined on timeout. */
+    QScriptValue wait(int msecs = -1);
+
+    /** Kill process. */
+    void kill();
+
+private:
+    /// Return false if there are no more data on standard output.
+    bool waitForOutput(bool wholeLine);
+
+    /// Process pending events and return false if script was aborted.
+    bool canWait();
+
+    Scriptable *m_scriptable;
+    QProcess *m_process;
+};
+
+#endif // SCRIPTABLEPROCESS_H
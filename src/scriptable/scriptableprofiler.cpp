@@ -0,0 +1,248 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scriptableprofiler.h"
+
+#include <QAtomicInt>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QThreadStorage>
+
+namespace {
+
+/// Upper bounds of histogram buckets in microseconds (last bucket is unbounded).
+const qint64 bucketBounds[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+    100000, 250000, 500000, 1000000, 5000000
+};
+
+const int bucketCount = sizeof(bucketBounds) / sizeof(bucketBounds[0]) + 1;
+
+struct Histogram {
+    Histogram()
+        : count(0), totalUs(0), maxUs(0)
+    {
+        for (int i = 0; i < bucketCount; ++i)
+            buckets[i] = 0;
+    }
+
+    void add(qint64 us)
+    {
+        ++count;
+        totalUs += us;
+        maxUs = qMax(maxUs, us);
+
+        int i = 0;
+        while ( i < bucketCount - 1 && us > bucketBounds[i] )
+            ++i;
+        ++buckets[i];
+    }
+
+    /// Return upper estimate of given percentile.
+    qint64 percentile(int percent) const
+    {
+        const int rank = (count * percent + 99) / 100;
+        int n = 0;
+        for (int i = 0; i < bucketCount - 1; ++i) {
+            n += buckets[i];
+            if (n >= rank)
+                return qMin(bucketBounds[i], maxUs);
+        }
+        return maxUs;
+    }
+
+    int count;
+    qint64 totalUs;
+    qint64 maxUs;
+    int buckets[bucketCount];
+};
+
+struct CommandTimes {
+    QElapsedTimer timer;
+    QMap<QString, qint64> times;
+};
+
+QAtomicInt profilerEnabled( qgetenv("COPYQ_PROFILE").isEmpty() ? 0 : 1 );
+
+QMutex histogramsLock;
+QMap<QString, Histogram> histograms;
+
+/// Times for command running in current thread.
+QThreadStorage<CommandTimes*> currentCommand;
+
+QString msToString(qint64 us)
+{
+    return QString::number(us / 1000.0, 'f', 1);
+}
+
+QString escapeJson(const QString &text)
+{
+    QString result;
+    foreach (const QChar &c, text) {
+        if ( c == '"' || c == '\\' )
+            result.append('\\').append(c);
+        else if ( c.unicode() < 0x20 )
+            result.append( QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0')) );
+        else
+            result.append(c);
+    }
+    return result;
+}
+
+} // namespace
+
+ScriptableProfiler::Timer::Timer(const char *name)
+    : m_name(name)
+{
+    if ( isEnabled() )
+        m_timer.start();
+    else
+        m_timer.invalidate();
+}
+
+ScriptableProfiler::Timer::~Timer()
+{
+    if ( m_timer.isValid() )
+        addTime( m_name, m_timer.nsecsElapsed() / 1000 );
+}
+
+bool ScriptableProfiler::isEnabled()
+{
+    return profilerEnabled.fetchAndAddOrdered(0) != 0;
+}
+
+void ScriptableProfiler::setEnabled(bool enabled)
+{
+    profilerEnabled.fetchAndStoreOrdered(enabled ? 1 : 0);
+}
+
+void ScriptableProfiler::reset()
+{
+    const QMutexLocker lock(&histogramsLock);
+    histograms.clear();
+}
+
+void ScriptableProfiler::beginCommand(qint64 queueWaitUs)
+{
+    if ( !isEnabled() ) {
+        currentCommand.setLocalData(NULL);
+        return;
+    }
+
+    CommandTimes *command = new CommandTimes;
+    command->timer.start();
+    command->times["queue_wait"] = queueWaitUs;
+    currentCommand.setLocalData(command);
+}
+
+void ScriptableProfiler::addTime(const char *name, qint64 us)
+{
+    CommandTimes *command = currentCommand.localData();
+    if (command == NULL)
+        return;
+
+    const QString key = QString::fromLatin1(name);
+    command->times[key] += us;
+
+    if ( key.startsWith("proxy.") )
+        command->times["proxy"] += us;
+}
+
+void ScriptableProfiler::endCommand()
+{
+    CommandTimes *command = currentCommand.localData();
+    if (command == NULL)
+        return;
+
+    command->times["total"] = command->timer.nsecsElapsed() / 1000;
+
+    {
+        const QMutexLocker lock(&histogramsLock);
+        for ( QMap<QString, qint64>::const_iterator it = command->times.constBegin();
+              it != command->times.constEnd(); ++it )
+        {
+            histograms[it.key()].add( it.value() );
+        }
+    }
+
+    currentCommand.setLocalData(NULL);
+}
+
+QString ScriptableProfiler::statistics()
+{
+    QString result = QString("%1 %2 %3 %4 %5 %6 %7\n")
+            .arg("time_ms", -32)
+            .arg("count", 7)
+            .arg("avg", 9)
+            .arg("p50", 9)
+            .arg("p90", 9)
+            .arg("p99", 9)
+            .arg("max", 9);
+
+    const QMutexLocker lock(&histogramsLock);
+
+    for ( QMap<QString, Histogram>::const_iterator it = histograms.constBegin();
+          it != histograms.constEnd(); ++it )
+    {
+        const Histogram &h = it.value();
+        result.append( QString("%1 %2 %3 %4 %5 %6 %7\n")
+                       .arg(it.key(), -32)
+                       .arg(h.count, 7)
+                       .arg(msToString(h.totalUs / qMax(1, h.count)), 9)
+                       .arg(msToString(h.percentile(50)), 9)
+                       .arg(msToString(h.percentile(90)), 9)
+                       .arg(msToString(h.percentile(99)), 9)
+                       .arg(msToString(h.maxUs), 9) );
+    }
+
+    return result;
+}
+
+QString ScriptableProfiler::statisticsJson()
+{
+    QStringList metrics;
+
+    const QMutexLocker lock(&histogramsLock);
+
+    for ( QMap<QString, Histogram>::const_iterator it = histograms.constBegin();
+          it != histograms.constEnd(); ++it )
+    {
+        const Histogram &h = it.value();
+
+        QStringList buckets;
+        for (int i = 0; i < bucketCount; ++i) {
+            const QString bound = i < bucketCount - 1 ? QString::number(bucketBounds[i]) : QString("null");
+            buckets.append( QString("{\"le_us\":%1,\"count\":%2}").arg(bound).arg(h.buckets[i]) );
+        }
+
+        metrics.append(
+                    QString("\"%1\":{\"count\":%2,\"total_us\":%3,\"max_us\":%4,\"buckets\":[%5]}")
+                    .arg(escapeJson(it.key()))
+                    .arg(h.count)
+                    .arg(h.totalUs)
+                    .arg(h.maxUs)
+                    .arg(buckets.join(",")) );
+    }
+
+    return QString("{\"enabled\":%1,\"metrics\":{%2}}")
+            .arg(isEnabled() ? "true" : "false")
+            .arg(metrics.join(","));
+}
@@ -0,0 +1,72 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCRIPTABLEPROFILER_H
+#define SCRIPTABLEPROFILER_H
+
+#include <QElapsedTimer>
+#include <QString>
+
+/**
+ * Opt-in timing statistics for client commands.
+ *
+ * Profiling is disabled by default and can be enabled with COPYQ_PROFILE
+ * environment variable or with "profile" command. Times measured in a
+ * thread running a command are summed per command invocation and
+ * aggregated into histograms when the command finishes.
+ *
+ * All methods are thread-safe.
+ */
+class ScriptableProfiler
+{
+public:
+    /** Measures time until destroyed and adds it to current command in this thread. */
+    class Timer {
+    public:
+        explicit Timer(const char *name);
+        ~Timer();
+    private:
+        const char *m_name;
+        QElapsedTimer m_timer;
+    };
+
+    static bool isEnabled();
+
+    static void setEnabled(bool enabled);
+
+    /** Clear collected statistics. */
+    static void reset();
+
+    /** Start measuring command in current thread (@a queueWaitUs is time spent in queue). */
+    static void beginCommand(qint64 queueWaitUs);
+
+    /** Add time spent in current command. */
+    static void addTime(const char *name, qint64 us);
+
+    /** Stop measuring command in current thread and aggregate statistics. */
+    static void endCommand();
+
+    /** Return histograms as text. */
+    static QString statistics();
+
+    /** Return histograms as JSON. */
+    static QString statisticsJson();
+};
+
+#endif // SCRIPTABLEPROFILER_H
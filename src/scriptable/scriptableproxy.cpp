@@ -44,6 +44,7 @@
 #include <QLineEdit>
 #include <QMimeData>
 #include <QPushButton>
+#include <QSet>
 #include <QSpinBox>
 #include <QTextEdit>
 
@@ -76,6 +77,20 @@ T setValue(QVariant &v, const T &value)
     return value;
 }
 
+QByteArray itemFormatData(const QVariantMap &data, const QString &mime)
+{
+    if ( data.isEmpty() )
+        return QByteArray();
+
+    if (mime == "?")
+        return QStringList(data.keys()).join("\n").toUtf8() + '\n';
+
+    if (mime == mimeItems)
+        return serializeData(data);
+
+    return data.value(mime).toByteArray();
+}
+
 QByteArray serializeWindow(WId winId)
 {
     QByteArray data;
@@ -521,21 +536,49 @@ QByteArray ScriptableProxyHelper::openActionDialog(const QVariantMap &arg1)
     return serializeWindow(m_wnd->openActionDialog(arg1));
 }
 
-bool ScriptableProxyHelper::loadTab(const QString &arg1)
+QString ScriptableProxyHelper::createUniqueTab(const QString &tabName)
 {
-    INVOKE(loadTab(arg1));
-    return m_wnd->loadTab(arg1);
+    INVOKE(createUniqueTab(tabName));
+
+    QString name = tabName;
+    renameToUnique( &name, m_wnd->tabs() );
+
+    return fetchBrowser(name) ? name : QString();
 }
 
-bool ScriptableProxyHelper::saveTab(const QString &arg1)
+int ScriptableProxyHelper::browserAppendItems(const QString &tabName, const QVariantList &items, bool merge)
 {
-    INVOKE(saveTab(arg1));
-    ClipboardBrowser *c = fetchBrowser();
-    if (!c)
-        return false;
+    INVOKE(browserAppendItems(tabName, items, merge));
+
+    ClipboardBrowser *c = fetchBrowser(tabName);
+    const ClipboardModel *model = c ? qobject_cast<const ClipboardModel*>(c->model()) : NULL;
+    if (!model)
+        return -1;
+
+    const int maxAdded = model->maxItems() - model->rowCount();
+
+    QList<QVariantMap> newItems;
+    QSet<uint> newHashes;
+    foreach (const QVariant &item, items) {
+        if ( newItems.size() >= maxAdded )
+            break;
+
+        const QVariantMap data = item.toMap();
+        if (merge) {
+            const uint itemHash = hash(data);
+            if ( newHashes.contains(itemHash) || model->findItem(itemHash) != -1 )
+                continue;
+            newHashes.insert(itemHash);
+        }
 
-    const int i = m_wnd->findTabIndex( c->tabName() );
-    return m_wnd->saveTab(arg1, i);
+        newItems.append(data);
+    }
+
+    ClipboardBrowser::Lock lock(c);
+    if ( !c->appendItems(newItems) )
+        return -1;
+
+    return newItems.size();
 }
 
 QVariant ScriptableProxyHelper::config(const QString &arg1, const QString &arg2)
@@ -620,6 +663,53 @@ QVariantMap ScriptableProxyHelper::browserItemData(int arg1)
     return itemData(arg1);
 }
 
+QVariantList ScriptableProxyHelper::browserItemsData(const QList<int> &rows, const QStringList &mimes)
+{
+    INVOKE(browserItemsData(rows, mimes));
+
+    ClipboardBrowser *c = fetchBrowser();
+
+    QVariantList result;
+    result.reserve( rows.size() );
+
+    for (int i = 0; i < rows.size(); ++i) {
+        const int row = rows[i];
+        const QString mime = mimes.value(i, mimeText);
+        if (row < 0)
+            result.append( getClipboardData(mime) );
+        else if (c)
+            result.append( itemFormatData(::itemData(c->index(row)), mime) );
+        else
+            result.append( QByteArray() );
+    }
+
+    return result;
+}
+
+QVariantList ScriptableProxyHelper::browserItemsData(const QList<int> &rows)
+{
+    INVOKE(browserItemsData(rows));
+
+    ClipboardBrowser *c = fetchBrowser();
+
+    QVariantList result;
+    result.reserve( rows.size() );
+
+    foreach (int row, rows)
+        result.append( c ? ::itemData(c->index(row)) : QVariantMap() );
+
+    return result;
+}
+
+ClipboardModelSnapshotPtr ScriptableProxyHelper::browserSnapshot()
+{
+    INVOKE(browserSnapshot());
+
+    ClipboardBrowser *c = fetchBrowser();
+    const ClipboardModel *model = c ? qobject_cast<const ClipboardModel*>(c->model()) : NULL;
+    return model ? model->snapshot() : ClipboardModelSnapshotPtr();
+}
+
 void ScriptableProxyHelper::setCurrentTab(const QString &tabName)
 {
     m_tabName = tabName;
@@ -935,17 +1025,7 @@ QVariantMap ScriptableProxyHelper::itemData(int i)
 
 QByteArray ScriptableProxyHelper::itemData(int i, const QString &mime)
 {
-    const QVariantMap data = itemData(i);
-    if ( data.isEmpty() )
-        return QByteArray();
-
-    if (mime == "?")
-        return QStringList(data.keys()).join("\n").toUtf8() + '\n';
-
-    if (mime == mimeItems)
-        return serializeData(data);
-
-    return data.value(mime).toByteArray();
+    return itemFormatData( itemData(i), mime );
 }
 
 bool ScriptableProxyHelper::canUseSelectedItems() const
@@ -963,3 +1043,91 @@ ScriptableProxy::ScriptableProxy(MainWindow *mainWindow, const QVariantMap &acti
 }
 
 ScriptableProxy::~ScriptableProxy() { delete m_helper; }
+
+int ScriptableProxy::browserLength()
+{
+    const ClipboardModelSnapshot *items = snapshot();
+    if (items)
+        return items->size();
+
+    BEGIN_INVOKE("browserLength")
+    END_INVOKE_AND_RETURN(int);
+}
+
+QByteArray ScriptableProxy::browserItemData(int row, const QString &mime)
+{
+    const ClipboardModelSnapshot *items = snapshot();
+    if (items)
+        return itemFormatData( items->itemData(row), mime );
+
+    BEGIN_INVOKE("browserItemData")
+        , Q_ARG(int, row)
+        , Q_ARG(const QString &, mime)
+    END_INVOKE_AND_RETURN(QByteArray);
+}
+
+QVariantMap ScriptableProxy::browserItemData(int row)
+{
+    const ClipboardModelSnapshot *items = snapshot();
+    if (items)
+        return items->itemData(row);
+
+    BEGIN_INVOKE("browserItemData")
+        , Q_ARG(int, row)
+    END_INVOKE_AND_RETURN(QVariantMap);
+}
+
+QVariantList ScriptableProxy::browserItemsData(const QList<int> &rows, const QStringList &mimes)
+{
+    // Clipboard (negative row) is read in GUI thread.
+    bool readsClipboard = false;
+    foreach (int row, rows)
+        readsClipboard = readsClipboard || row < 0;
+
+    const ClipboardModelSnapshot *items = readsClipboard ? NULL : snapshot();
+    if (items) {
+        QVariantList result;
+        result.reserve( rows.size() );
+        for (int i = 0; i < rows.size(); ++i)
+            result.append( itemFormatData(items->itemData(rows[i]), mimes.value(i, mimeText)) );
+        return result;
+    }
+
+    BEGIN_INVOKE("browserItemsData")
+        , Q_ARG(const QList<int> &, rows)
+        , Q_ARG(const QStringList &, mimes)
+    END_INVOKE_AND_RETURN(QVariantList);
+}
+
+QVariantList ScriptableProxy::browserItemsData(const QList<int> &rows)
+{
+    const ClipboardModelSnapshot *items = snapshot();
+    if (items) {
+        QVariantList result;
+        result.reserve( rows.size() );
+        foreach (int row, rows)
+            result.append( items->itemData(row) );
+        return result;
+    }
+
+    BEGIN_INVOKE("browserItemsData")
+        , Q_ARG(const QList<int> &, rows)
+    END_INVOKE_AND_RETURN(QVariantList);
+}
+
+void ScriptableProxy::setCurrentTab(const QString &tabName)
+{
+    m_snapshot.clear();
+
+    BEGIN_INVOKE("setCurrentTab")
+        , Q_ARG(const QString &, tabName)
+    END_INVOKE;
+}
+
+const ClipboardModelSnapshot *ScriptableProxy::snapshot()
+{
+    if ( !m_snapshot || !m_snapshot->isValid() )
+        m_snapshot = browserSnapshot();
+
+    return m_snapshot ? m_snapshot.data() : NULL;
+}
@@ -21,6 +21,7 @@
 #define SCRIPTABLEPROXY_H
 
 #include "gui/clipboardbrowser.h"
+#include "scriptable/scriptableprofiler.h"
 
 #include <QClipboard>
 #include <QList>
@@ -51,6 +52,7 @@ Q_DECLARE_METATYPE(QList<int>)
 #endif
 
 #define BEGIN_INVOKE(methodName) \
+    const ScriptableProfiler::Timer proxyCallTimer("proxy." methodName); \
     m_helper->unsetValue(); \
     QMetaObject::invokeMethod(m_helper, methodName, Qt::BlockingQueuedConnection
 
@@ -215,8 +217,15 @@ public slots:
 
     QByteArray openActionDialog(const QVariantMap &arg1);
 
-    bool loadTab(const QString &arg1);
-    bool saveTab(const QString &arg1);
+    /** Create new tab with unique name based on @a tabName and return its name. */
+    QString createUniqueTab(const QString &tabName);
+
+    /**
+     * Append items (QVariantMap) to a tab and return number of added items (-1 on error).
+     *
+     * If @a merge is true, items already in the tab are skipped.
+     */
+    int browserAppendItems(const QString &tabName, const QVariantList &items, bool merge);
 
     QVariant config(const QString &arg1, const QString &arg2);
 
@@ -233,6 +242,13 @@ public slots:
     QByteArray browserItemData(int arg1, const QString &arg2);
     QVariantMap browserItemData(int arg1);
 
+    /** Return data (QByteArray) for each row in given format; negative row is clipboard. */
+    QVariantList browserItemsData(const QList<int> &rows, const QStringList &mimes);
+    /** Return data of items (QVariantMap) in rows. */
+    QVariantList browserItemsData(const QList<int> &rows);
+
+    ClipboardModelSnapshotPtr browserSnapshot();
+
     void setCurrentTab(const QString &tabName);
 
     QString currentTab();
@@ -327,8 +343,8 @@ public:
     PROXY_METHOD_1(QByteArray, openActionDialog, const QVariantMap &)
     PROXY_METHOD_VOID_2(action, const QVariantMap &, const Command &)
 
-    PROXY_METHOD_1(bool, loadTab, const QString &)
-    PROXY_METHOD_1(bool, saveTab, const QString &)
+    PROXY_METHOD_1(QString, createUniqueTab, const QString &)
+    PROXY_METHOD_3(int, browserAppendItems, const QString &, const QVariantList &, bool)
 
     PROXY_METHOD_2(QVariant, config, const QString &, const QString &)
 
@@ -344,7 +360,7 @@ public:
     PROXY_METHOD_VOID_1(browserMoveToClipboard, int)
     PROXY_METHOD_VOID_1(browserRemoveRows, const QList<int> &)
     PROXY_METHOD_VOID_1(browserSetCurrent, int)
-    PROXY_METHOD_0(int, browserLength)
+    int browserLength();
     PROXY_METHOD_2(bool, browserOpenEditor, const QByteArray &, bool)
 
     PROXY_METHOD_1(bool, browserAdd, const QString &)
@@ -354,10 +370,12 @@ public:
     PROXY_METHOD_VOID_1(browserEditRow, int)
     PROXY_METHOD_VOID_2(browserEditNew, const QString &, bool)
 
-    PROXY_METHOD_2(QByteArray, browserItemData, int, const QString &)
-    PROXY_METHOD_1(QVariantMap, browserItemData, int)
+    QByteArray browserItemData(int row, const QString &mime);
+    QVariantMap browserItemData(int row);
+    QVariantList browserItemsData(const QList<int> &rows, const QStringList &mimes);
+    QVariantList browserItemsData(const QList<int> &rows);
 
-    PROXY_METHOD_VOID_1(setCurrentTab, const QString &)
+    void setCurrentTab(const QString &tabName);
     PROXY_METHOD_0(QString, currentTab)
 
     PROXY_METHOD_0(int, currentItem)
@@ -378,8 +396,19 @@ public:
     PROXY_METHOD_VOID_1(updateFirstItem, const QVariantMap &)
     PROXY_METHOD_VOID_1(updateTitle, const QVariantMap &)
 
+    PROXY_METHOD_0(ClipboardModelSnapshotPtr, browserSnapshot)
+
 private:
+
+    /**
+     * Return up-to-date snapshot of items in current tab or NULL.
+     *
+     * Items are read from snapshot without waiting for GUI thread until the tab changes.
+     */
+    const ClipboardModelSnapshot *snapshot();
+
     detail::ScriptableProxyHelper *m_helper; ///< For retrieving return values of methods in MainWindow.
+    ClipboardModelSnapshotPtr m_snapshot;
 };
 
 #endif // SCRIPTABLEPROXY_H
@@ -26,11 +26,17 @@
 #include "common/log.h"
 #include "gui/configurationmanager.h"
 #include "item/itemfactory.h"
+#include "scriptable/scriptableprofiler.h"
 #include "../qt/bytearrayclass.h"
 
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
 #include <QObject>
 #include <QScriptEngine>
+#include <QScriptValueIterator>
+#include <QThreadStorage>
 
 Q_DECLARE_METATYPE(QByteArray*)
 
@@ -58,6 +64,137 @@ QByteArray serializeScriptValue(const QScriptValue &value)
     return data;
 }
 
+/**
+ * Script engine with initialized global object and evaluated plugin script.
+ *
+ * Engine is reused by commands running in the same thread. Global variables,
+ * properties of global objects (e.g. Math) and prototypes of global
+ * constructors (e.g. String.prototype) are restored to the initial state
+ * before each command.
+ */
+class ScriptEngine
+{
+public:
+    explicit ScriptEngine(const QString &pluginScript)
+        : m_engine()
+        , m_scriptable(NULL)
+        , m_pluginScript(pluginScript)
+    {
+        m_scriptable.initEngine( &m_engine, QString(), QVariantMap() );
+        m_engine.evaluate(m_pluginScript);
+        m_engine.clearExceptions();
+
+        QObject::connect( &m_scriptable, SIGNAL(requestApplicationQuit()),
+                          qApp, SLOT(quit()) );
+
+        const QScriptValue globalObject = m_engine.globalObject();
+        saveObject(globalObject);
+
+        QScriptValueIterator it(globalObject);
+        while ( it.hasNext() ) {
+            it.next();
+            const QScriptValue value = it.value();
+            if ( !value.isObject() )
+                continue;
+
+            saveObject(value);
+
+            const QScriptValue prototype = value.property("prototype");
+            if ( value.isFunction() && prototype.isObject() )
+                saveObject(prototype);
+        }
+    }
+
+    const QString &pluginScript() const { return m_pluginScript; }
+
+    QScriptEngine *engine() { return &m_engine; }
+
+    Scriptable *scriptable() { return &m_scriptable; }
+
+    /// Remove or restore global variables and built-ins changed by previous command.
+    void reset()
+    {
+        m_engine.clearExceptions();
+
+        foreach (const SavedObject &savedObject, m_savedObjects)
+            restoreObject(savedObject);
+    }
+
+private:
+    struct SavedProperty {
+        QScriptValue value;
+        QScriptValue::PropertyFlags flags;
+    };
+
+    struct SavedObject {
+        QScriptValue object;
+        QHash<QString, SavedProperty> properties;
+    };
+
+    void saveObject(const QScriptValue &object)
+    {
+        SavedObject savedObject;
+        savedObject.object = object;
+
+        QScriptValueIterator it(object);
+        while ( it.hasNext() ) {
+            it.next();
+            const SavedProperty property = { it.value(), it.flags() };
+            savedObject.properties.insert( it.name(), property );
+        }
+
+        m_savedObjects.append(savedObject);
+    }
+
+    static void restoreObject(const SavedObject &savedObject)
+    {
+        QScriptValue object = savedObject.object;
+        const QHash<QString, SavedProperty> &properties = savedObject.properties;
+
+        QScriptValueIterator it(object);
+        while ( it.hasNext() ) {
+            it.next();
+            if ( !properties.contains(it.name()) )
+                it.remove();
+        }
+
+        for ( QHash<QString, SavedProperty>::const_iterator it2 = properties.constBegin();
+              it2 != properties.constEnd(); ++it2 )
+        {
+            const QScriptValue value = object.property( it2.key() );
+            if ( !value.strictlyEquals(it2.value().value) )
+                object.setProperty( it2.key(), it2.value().value, it2.value().flags );
+        }
+    }
+
+    QScriptEngine m_engine;
+    Scriptable m_scriptable;
+    QString m_pluginScript;
+
+    /// Global object, global objects and prototypes of global constructors.
+    QList<SavedObject> m_savedObjects;
+};
+
+/// Script engine for current thread (engines are deleted when threads finish).
+QThreadStorage<ScriptEngine*> scriptEngines;
+
+ScriptEngine *scriptEngineForCurrentThread(const QString &pluginScript)
+{
+    ScriptEngine *scriptEngine = scriptEngines.localData();
+
+    if ( scriptEngine == NULL || scriptEngine->pluginScript() != pluginScript ) {
+        QElapsedTimer t;
+        t.start();
+        scriptEngine = new ScriptEngine(pluginScript);
+        scriptEngines.setLocalData(scriptEngine);
+        COPYQ_LOG( QString("Script engine created in %1 ms").arg(t.elapsed()) );
+    } else {
+        scriptEngine->reset();
+    }
+
+    return scriptEngine;
+}
+
 } // namespace
 
 ScriptableWorker::ScriptableWorker(MainWindow *mainWindow,
@@ -70,10 +207,14 @@ ScriptableWorker::ScriptableWorker(MainWindow *mainWindow,
 {
     if ( hasLogLevel(LogDebug) )
         m_id = m_socket->property("id").toString();
+
+    m_queuedTime.start();
 }
 
 void ScriptableWorker::run()
 {
+    ScriptableProfiler::beginCommand( m_queuedTime.nsecsElapsed() / 1000 );
+
     if ( hasLogLevel(LogDebug) ) {
         bool isEval = m_args.length() == Arguments::Rest + 2
                 && m_args.at(Arguments::Rest) == "eval";
@@ -96,10 +237,16 @@ void ScriptableWorker::run()
 
     const QString currentPath = QString::fromUtf8(m_args.at(Arguments::CurrentPath));
 
-    QScriptEngine engine;
+    ScriptEngine *scriptEngine;
+    {
+        const ScriptableProfiler::Timer timer("setup");
+        scriptEngine = scriptEngineForCurrentThread(m_pluginScript);
+    }
+    QScriptEngine &engine = *scriptEngine->engine();
+    Scriptable &scriptable = *scriptEngine->scriptable();
+
     ScriptableProxy proxy(m_wnd, data);
-    Scriptable scriptable(&proxy);
-    scriptable.initEngine(&engine, currentPath, data);
+    scriptable.reset(&proxy, currentPath, data);
 
     if (m_socket) {
         QObject::connect( proxy.signaler(), SIGNAL(sendMessage(QByteArray,int)),
@@ -112,20 +259,16 @@ void ScriptableWorker::run()
 
         QObject::connect( m_socket, SIGNAL(disconnected()),
                           &scriptable, SLOT(abort()) );
-        QObject::connect( &scriptable, SIGNAL(destroyed()),
-                          m_socket, SLOT(deleteAfterDisconnected()) );
 
         if ( m_socket->isClosed() ) {
             MONITOR_LOG("TERMINATED");
+            finish(&scriptable);
             return;
         }
 
         m_socket->start();
     }
 
-    QObject::connect( &scriptable, SIGNAL(requestApplicationQuit()),
-                      qApp, SLOT(quit()) );
-
     QByteArray response;
     int exitCode;
 
@@ -139,6 +282,7 @@ void ScriptableWorker::run()
         if ( cmd == "flush" && m_args.length() == Arguments::Rest + 2 ) {
             MONITOR_LOG( "flush ID: " + QString::fromUtf8(m_args.at(Arguments::Rest + 1)) );
             scriptable.sendMessageToClient(QByteArray(), CommandFinished);
+            finish(&scriptable);
             return;
         }
 #endif
@@ -156,7 +300,6 @@ void ScriptableWorker::run()
             for ( int i = Arguments::Rest + 1; i < m_args.length(); ++i )
                 fnArgs.append( scriptable.newByteArray(m_args.at(i)) );
 
-            engine.evaluate(m_pluginScript);
             QScriptValue result = fn.call(QScriptValue(), fnArgs);
 
             if ( engine.hasUncaughtException() ) {
@@ -179,5 +322,25 @@ void ScriptableWorker::run()
 
     scriptable.sendMessageToClient(response, exitCode);
 
+    finish(&scriptable);
+
     MONITOR_LOG("DONE");
 }
+
+void ScriptableWorker::finish(Scriptable *scriptable)
+{
+    // Release proxy and processes started by the command.
+    scriptable->reset( NULL, QString(), QVariantMap() );
+
+    ScriptableProfiler::endCommand();
+
+    if (m_socket == NULL)
+        return;
+
+    // Scriptable object is reused by next command in this thread.
+    QObject::disconnect( scriptable, NULL, m_socket, NULL );
+    QObject::disconnect( m_socket, NULL, scriptable, NULL );
+    QCoreApplication::removePostedEvents(scriptable);
+
+    QMetaObject::invokeMethod( m_socket, "deleteAfterDisconnected", Qt::QueuedConnection );
+}
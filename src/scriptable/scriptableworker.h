@@ -26,6 +26,7 @@
 #include "scriptable/scriptable.h"
 #include "scriptable/scriptableproxy.h"
 
+#include <QElapsedTimer>
 #include <QRunnable>
 
 class ClientSocket;
@@ -38,11 +39,15 @@ public:
     void run();
 
 private:
+    /// Disconnect reused scriptable object from client.
+    void finish(Scriptable *scriptable);
+
     MainWindow *m_wnd;
     Arguments m_args;
     ClientSocket *m_socket;
     QString m_pluginScript;
     QString m_id;
+    QElapsedTimer m_queuedTime;
 };
 
 #endif // SCRIPTABLEWORKER_H
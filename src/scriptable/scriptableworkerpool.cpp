@@ -0,0 +1,288 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scriptableworkerpool.h"
+
+#include "common/arguments.h"
+#include "common/log.h"
+#include "scriptable/scriptableworker.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QScopedPointer>
+
+namespace {
+
+/// Maximum number of queued commands for each priority.
+const int maxQueuedCommands[] = { 16, 128, 128 };
+
+const char *const priorityNames[] = { "interactive", "automatic", "batch" };
+
+struct PriorityStatistics {
+    PriorityStatistics()
+        : queued(0), running(0), finished(0), rejected(0)
+        , totalWaitMs(0), maxWaitMs(0), totalRunMs(0), maxRunMs(0)
+    {}
+
+    int queued;
+    int running;
+    int finished;
+    int rejected;
+    qint64 totalWaitMs;
+    qint64 maxWaitMs;
+    qint64 totalRunMs;
+    qint64 maxRunMs;
+};
+
+QMutex statisticsLock;
+PriorityStatistics priorityStatistics[ScriptableWorkerPool::PriorityCount];
+
+bool isInteractiveCommand(const QByteArray &cmd)
+{
+    static const char *const commands[] = {
+        "show", "hide", "toggle", "menu", "exit", "edit", "action", "dialog", "disable", "enable"
+    };
+
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i) {
+        if (cmd == commands[i])
+            return true;
+    }
+
+    return false;
+}
+
+QString averageMs(qint64 totalMs, int count)
+{
+    return count > 0 ? QString::number(totalMs / count) : QString("-");
+}
+
+class PoolRunnable : public QRunnable
+{
+public:
+    PoolRunnable(ScriptableWorker *worker, QObject *pool, int priority)
+        : m_worker(worker)
+        , m_pool(pool)
+        , m_priority(priority)
+    {
+    }
+
+    void run()
+    {
+        QElapsedTimer t;
+        t.start();
+
+        m_worker->run();
+
+        QMetaObject::invokeMethod(
+                    m_pool, "onWorkerFinished", Qt::QueuedConnection,
+                    Q_ARG(int, m_priority), Q_ARG(int, static_cast<int>(t.elapsed())) );
+    }
+
+private:
+    QScopedPointer<ScriptableWorker> m_worker;
+    QObject *m_pool;
+    int m_priority;
+};
+
+} // namespace
+
+ScriptableWorkerPool::ScriptableWorkerPool(QObject *parent)
+    : QObject(parent)
+    , m_threads()
+    , m_running(0)
+{
+    // Allow to run at least few client and internal threads concurrently.
+    m_threads.setMaxThreadCount( qMax(m_threads.maxThreadCount(), 8) );
+
+    for (int i = 0; i < PriorityCount; ++i)
+        m_queues[i].size = 0;
+}
+
+ScriptableWorkerPool::~ScriptableWorkerPool()
+{
+    waitForDone(-1);
+}
+
+ScriptableWorkerPool::Priority ScriptableWorkerPool::commandPriority(
+        const Arguments &args, const QObject *client, QString *source)
+{
+    // Commands from an action, from processes started by the same program
+    // (e.g. a shell script) or else from the same connection share a source.
+    const QByteArray actionId = args.at(Arguments::ActionId);
+    const QByteArray parentProcessId = args.at(Arguments::ParentProcessId);
+    if ( !actionId.isEmpty() )
+        *source = "action " + QString::fromUtf8(actionId);
+    else if ( !parentProcessId.isEmpty() )
+        *source = "process " + QString::fromUtf8(parentProcessId);
+    else
+        *source = "client " + QString::number( reinterpret_cast<quintptr>(client) );
+
+    if ( args.length() > Arguments::Rest && isInteractiveCommand(args.at(Arguments::Rest)) )
+        return Interactive;
+
+    return actionId.isEmpty() ? Batch : Automatic;
+}
+
+bool ScriptableWorkerPool::start(
+        ScriptableWorker *worker, Priority priority, const QString &source, QString *error)
+{
+    PriorityQueue &queue = m_queues[priority];
+    QQueue<QueuedWorker> &sourceQueue = queue.sources[source];
+
+    // One source can fill only half of the queue.
+    const int maxQueued = maxQueuedCommands[priority];
+    if ( queue.size >= maxQueued || sourceQueue.size() >= maxQueued / 2 ) {
+        if ( sourceQueue.isEmpty() )
+            queue.sources.remove(source);
+
+        *error = tr("Too many %1 commands are queued, try again later.")
+                .arg(priorityNames[priority]);
+
+        const QMutexLocker lock(&statisticsLock);
+        ++priorityStatistics[priority].rejected;
+        return false;
+    }
+
+    QueuedWorker queuedWorker;
+    queuedWorker.worker = worker;
+    queuedWorker.queuedTime.start();
+
+    if ( sourceQueue.isEmpty() )
+        queue.sourceOrder.append(source);
+    sourceQueue.enqueue(queuedWorker);
+    ++queue.size;
+
+    {
+        const QMutexLocker lock(&statisticsLock);
+        ++priorityStatistics[priority].queued;
+    }
+
+    dispatch();
+
+    return true;
+}
+
+int ScriptableWorkerPool::activeCount() const
+{
+    int count = m_running;
+    for (int i = 0; i < PriorityCount; ++i)
+        count += m_queues[i].size;
+    return count;
+}
+
+bool ScriptableWorkerPool::waitForDone(int msecs)
+{
+    for (int i = 0; i < PriorityCount; ++i) {
+        PriorityQueue &queue = m_queues[i];
+        foreach (const QQueue<QueuedWorker> &sourceQueue, queue.sources) {
+            foreach (const QueuedWorker &queuedWorker, sourceQueue)
+                delete queuedWorker.worker;
+        }
+
+        const QMutexLocker lock(&statisticsLock);
+        priorityStatistics[i].queued -= queue.size;
+
+        queue.sources.clear();
+        queue.sourceOrder.clear();
+        queue.size = 0;
+    }
+
+    return m_threads.waitForDone(msecs);
+}
+
+QString ScriptableWorkerPool::statistics()
+{
+    QString result = QString("%1 %2 %3 %4 %5 %6 %7\n")
+            .arg("priority", -12)
+            .arg("queued", 7)
+            .arg("running", 8)
+            .arg("finished", 9)
+            .arg("rejected", 9)
+            .arg("wait_ms(avg/max)", 17)
+            .arg("run_ms(avg/max)", 16);
+
+    const QMutexLocker lock(&statisticsLock);
+
+    for (int i = 0; i < PriorityCount; ++i) {
+        const PriorityStatistics &s = priorityStatistics[i];
+        const int started = s.running + s.finished;
+        result.append( QString("%1 %2 %3 %4 %5 %6 %7\n")
+                       .arg(priorityNames[i], -12)
+                       .arg(s.queued, 7)
+                       .arg(s.running, 8)
+                       .arg(s.finished, 9)
+                       .arg(s.rejected, 9)
+                       .arg(averageMs(s.totalWaitMs, started) + "/" + QString::number(s.maxWaitMs), 17)
+                       .arg(averageMs(s.totalRunMs, s.finished) + "/" + QString::number(s.maxRunMs), 16) );
+    }
+
+    return result;
+}
+
+void ScriptableWorkerPool::onWorkerFinished(int priority, int runMs)
+{
+    --m_running;
+
+    {
+        const QMutexLocker lock(&statisticsLock);
+        PriorityStatistics &s = priorityStatistics[priority];
+        --s.running;
+        ++s.finished;
+        s.totalRunMs += runMs;
+        s.maxRunMs = qMax<qint64>(s.maxRunMs, runMs);
+    }
+
+    dispatch();
+}
+
+void ScriptableWorkerPool::dispatch()
+{
+    for (int priority = 0; priority < PriorityCount; ++priority) {
+        PriorityQueue &queue = m_queues[priority];
+
+        while ( queue.size > 0 && m_running < m_threads.maxThreadCount() ) {
+            // Serve sources in turn.
+            const QString source = queue.sourceOrder.takeFirst();
+            QQueue<QueuedWorker> &sourceQueue = queue.sources[source];
+            const QueuedWorker queuedWorker = sourceQueue.dequeue();
+            if ( sourceQueue.isEmpty() )
+                queue.sources.remove(source);
+            else
+                queue.sourceOrder.append(source);
+            --queue.size;
+
+            const qint64 waitMs = queuedWorker.queuedTime.elapsed();
+            {
+                const QMutexLocker lock(&statisticsLock);
+                PriorityStatistics &s = priorityStatistics[priority];
+                --s.queued;
+                ++s.running;
+                s.totalWaitMs += waitMs;
+                s.maxWaitMs = qMax(s.maxWaitMs, waitMs);
+            }
+
+            COPYQ_LOG( QString("Starting %1 command (waited %2 ms)")
+                       .arg(priorityNames[priority]).arg(waitMs) );
+
+            ++m_running;
+            m_threads.start( new PoolRunnable(queuedWorker.worker, this, priority) );
+        }
+    }
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright (c) 2015, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCRIPTABLEWORKERPOOL_H
+#define SCRIPTABLEWORKERPOOL_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+class Arguments;
+class ScriptableWorker;
+
+/**
+ * Runs client commands (ScriptableWorker) in thread pool.
+ *
+ * Commands are queued by priority and, within same priority, taken from each
+ * source (action or program starting clients) in turn. Too many queued
+ * commands are rejected instead of slowing down the server indefinitely.
+ */
+class ScriptableWorkerPool : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        /// Commands controlling GUI (e.g. show, toggle, menu).
+        Interactive,
+        /// Commands started from actions (automatic, menu and shortcut commands).
+        Automatic,
+        /// Other commands from command line.
+        Batch,
+        PriorityCount
+    };
+
+    explicit ScriptableWorkerPool(QObject *parent = NULL);
+
+    ~ScriptableWorkerPool();
+
+    /** Return priority and source ID for command from @a client connection. */
+    static Priority commandPriority(const Arguments &args, const QObject *client, QString *source);
+
+    /**
+     * Queue worker to run when a thread is available.
+     *
+     * Takes ownership of worker if successful. Returns false and sets
+     * @a error if queue for given priority or source is full.
+     */
+    bool start(ScriptableWorker *worker, Priority priority, const QString &source, QString *error);
+
+    /** Return number of running and queued commands. */
+    int activeCount() const;
+
+    /** Remove queued commands and wait for running commands to finish. */
+    bool waitForDone(int msecs);
+
+    /**
+     * Return queue depth and latency statistics as text.
+     *
+     * This method is thread-safe.
+     */
+    static QString statistics();
+
+private slots:
+    void onWorkerFinished(int priority, int runMs);
+
+private:
+    struct QueuedWorker {
+        ScriptableWorker *worker;
+        QElapsedTimer queuedTime;
+    };
+
+    struct PriorityQueue {
+        QMap< QString, QQueue<QueuedWorker> > sources;
+        QStringList sourceOrder; ///< Sources with queued commands; first is served next.
+        int size;
+    };
+
+    /// Start queued workers while there are free threads.
+    void dispatch();
+
+    QThreadPool m_threads;
+    PriorityQueue m_queues[PriorityCount];
+    int m_running;
+};
+
+#endif // SCRIPTABLEWORKERPOOL_H
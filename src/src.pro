@@ -26,13 +26,18 @@ FORMS += \
     ui/addcommanddialog.ui
 HEADERS += \
     app/app.h \
+    app/clientsubscriptions.h \
+    app/clipboardchangecoalescer.h \
     app/clipboardclient.h \
     app/clipboardmonitor.h \
+    app/clipboardmonitorworker.h \
     app/clipboardserver.h \
     app/remoteprocess.h \
     common/action.h \
+    common/actionstatistics.h \
     common/arguments.h \
     common/client_server.h \
+    common/clipboardchangestatistics.h \
     common/clientsocket.h \
     common/command.h \
     common/common.h \
@@ -85,9 +90,12 @@ HEADERS += \
     scriptable/fileclass.h \
     scriptable/fileprototype.h \
     scriptable/scriptableclass.h \
+    scriptable/scriptableprocess.h \
+    scriptable/scriptableprofiler.h \
     scriptable/scriptable.h \
     scriptable/scriptableproxy.h \
     scriptable/scriptableworker.h \
+    scriptable/scriptableworkerpool.h \
     tests/testinterface.h \
     app/client.h \
     common/mimetypes.h \
@@ -106,17 +114,24 @@ HEADERS += \
     scriptable/dirprototype.h \
     gui/commandaction.h \
     gui/addcommanddialog.h \
+    common/commandmatcher.h \
     common/commandtester.h \
+    common/coprocess.h \
     gui/filtercompleter.h
 SOURCES += \
     app/app.cpp \
+    app/clientsubscriptions.cpp \
+    app/clipboardchangecoalescer.cpp \
     app/clipboardclient.cpp \
     app/clipboardmonitor.cpp \
+    app/clipboardmonitorworker.cpp \
     app/clipboardserver.cpp \
     app/remoteprocess.cpp \
     common/action.cpp \
+    common/actionstatistics.cpp \
     common/arguments.cpp \
     common/client_server.cpp \
+    common/clipboardchangestatistics.cpp \
     common/clientsocket.cpp \
     common/common.cpp \
     common/option.cpp \
@@ -165,9 +180,12 @@ SOURCES += \
     scriptable/fileclass.cpp \
     scriptable/fileprototype.cpp \
     scriptable/scriptableclass.cpp \
+    scriptable/scriptableprocess.cpp \
+    scriptable/scriptableprofiler.cpp \
     scriptable/scriptable.cpp \
     scriptable/scriptableproxy.cpp \
     scriptable/scriptableworker.cpp \
+    scriptable/scriptableworkerpool.cpp \
     app/client.cpp \
     common/mimetypes.cpp \
     common/log.cpp \
@@ -183,7 +201,9 @@ SOURCES += \
     scriptable/dirprototype.cpp \
     gui/commandaction.cpp \
     gui/addcommanddialog.cpp \
+    common/commandmatcher.cpp \
     common/commandtester.cpp \
+    common/coprocess.cpp \
     gui/filtercompleter.cpp
 
 macx {
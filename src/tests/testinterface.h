@@ -96,6 +96,9 @@ public:
     /// Init test.
     virtual QByteArray init() = 0;
 
+    /// Set test ID and settings for server (used when server starts).
+    virtual void setupTest(const QString &id, const QVariant &settings) = 0;
+
     /// Clean up tabs and items. Return error string on error.
     virtual QByteArray cleanup() = 0;
 
@@ -19,26 +19,37 @@
 
 #include "tests.h"
 
+#include "app/clipboardchangecoalescer.h"
 #include "app/remoteprocess.h"
+#include "common/action.h"
+#include "common/actionstatistics.h"
+#include "common/arguments.h"
 #include "common/client_server.h"
+#include "common/commandmatcher.h"
+#include "common/commandtester.h"
 #include "common/common.h"
 #include "common/mimetypes.h"
 #include "common/monitormessagecode.h"
+#include "item/clipboardmodel.h"
 #include "item/itemfactory.h"
 #include "item/itemwidget.h"
 #include "item/serialize.h"
 #include "gui/configtabshortcuts.h"
+#include "scriptable/scriptableworkerpool.h"
 
 #include <QApplication>
+#include <QBuffer>
 #include <QClipboard>
 #include <QDir>
 #include <QElapsedTimer>
 #include <QFileInfo>
+#include <QImage>
 #include <QMap>
 #include <QMimeData>
 #include <QProcess>
 #include <QRegExp>
 #include <QScopedPointer>
+#include <QSignalSpy>
 #include <QTemporaryFile>
 #include <QTest>
 
@@ -92,6 +103,11 @@ void waitFor(int ms)
         QApplication::processEvents(QEventLoop::AllEvents, ms);
 }
 
+QByteArray snapshotText(const ClipboardModelSnapshotPtr &snapshot, int row)
+{
+    return snapshot->itemData(row).value(mimeText).toByteArray();
+}
+
 /// Naming scheme for test tabs in application.
 QString testTab(int index)
 {
@@ -581,6 +597,119 @@ QString keyNameFor(QKeySequence::StandardKey standardKey)
     return QKeySequence(standardKey).toString();
 }
 
+Command filterCommand(const QString &name, const QString &matchCmd)
+{
+    Command command;
+    command.name = name;
+    command.matchCmd = matchCmd;
+    return command;
+}
+
+/// Return names of commands and test results emitted by CommandTester.
+QString commandTesterResults(const QSignalSpy &spy)
+{
+    QString results;
+    for (int i = 0; i < spy.count(); ++i) {
+        const Command command = spy[i][0].value<Command>();
+        results.append( command.name + (spy[i][1].toBool() ? "+" : "-") );
+    }
+    return results;
+}
+
+bool waitForCommandTester(const CommandTester &tester, const QSignalSpy &spy, int count)
+{
+    QElapsedTimer t;
+    t.start();
+    while ( (spy.count() < count || !tester.isCompleted()) && t.elapsed() < 8000 )
+        waitFor(20);
+    return spy.count() == count && tester.isCompleted();
+}
+
+Action *startAction(const QString &command, const QByteArray &input, bool coprocess, QObject *parent)
+{
+    Action *action = new Action(parent);
+    action->setCommand( command, QStringList(QString::fromUtf8(input)) );
+    action->setInput(input);
+    action->setOutputFormat("DATA");
+    action->setCoprocess(coprocess);
+    action->start();
+    return action;
+}
+
+bool waitForActions(const QList<Action*> &actions)
+{
+    QElapsedTimer t;
+    t.start();
+    while ( t.elapsed() < 8000 ) {
+        bool running = false;
+        foreach (const Action *action, actions)
+            running = running || action->isRunning();
+        if (!running)
+            return true;
+        waitFor(20);
+    }
+    return false;
+}
+
+/// Return items emitted by action while its output is split with separator.
+QStringList actionOutputItems(const QString &command, const QString &separator)
+{
+    Action action;
+    action.setCommand(command);
+    action.setOutputFormat(mimeText);
+    action.setItemSeparator( QRegExp(separator) );
+    action.setOutputTab("test");
+
+    QSignalSpy spy( &action, SIGNAL(newItems(QStringList,QString)) );
+    action.start();
+    if ( !waitForActions(QList<Action*>() << &action) )
+        return QStringList("TIMEOUT");
+
+    QStringList items;
+    for (int i = 0; i < spy.count(); ++i)
+        items.append( spy[i][0].toStringList() );
+    return items;
+}
+
+QVariantMap automaticCommandSettings(
+        const QString &match, const QString &command, const QString &outputTab)
+{
+    QVariantMap settings;
+    settings["Automatic"] = true;
+    settings["Match"] = match;
+    settings["Command"] = command;
+    if ( !outputTab.isEmpty() ) {
+        settings["Output"] = mimeText;
+        settings["OutputTab"] = outputTab;
+        settings["Separator"] = "\\n";
+    }
+    return settings;
+}
+
+/// Return server settings with commands (loaded when server starts).
+QVariantMap commandsSettings(const QList<QVariantMap> &commands)
+{
+    QVariantMap settings;
+    settings["Commands/size"] = commands.size();
+    for (int i = 0; i < commands.size(); ++i) {
+        foreach ( const QString &key, commands[i].keys() )
+            settings[ QString("Commands/%1/%2").arg(i + 1).arg(key) ] = commands[i][key];
+    }
+    return settings;
+}
+
+Arguments clientArguments(const QByteArray &actionId, const QByteArray &parentProcessId,
+                          const QByteArray &command)
+{
+    Arguments args;
+    args.removeAllArguments();
+    args.append( QDir::currentPath().toUtf8() );
+    args.append(actionId);
+    args.append(parentProcessId);
+    args.append(command);
+    return args;
+}
+
 } // namespace
 
 Tests::Tests(const TestInterfacePtr &test, QObject *parent)
@@ -855,6 +984,42 @@ void Tests::clipboardToItem()
     RUN(Args("read") << "0", bytes);
 }
 
+void Tests::clipboardToItemInProcess()
+{
+    QVariantMap settings;
+    settings["Options/monitor_in_process"] = true;
+
+    TEST( m_test->stopServer() );
+    m_test->setupTest("CORE", settings);
+    TEST( m_test->init() );
+    TEST( m_test->cleanup() );
+
+    TEST( m_test->setClipboard("TEST0") );
+    RUN(Args("clipboard"), "TEST0");
+
+    TEST( m_test->setClipboard("TEST1") );
+    RUN(Args("clipboard"), "TEST1");
+    RUN(Args("read") << "0", "TEST1");
+
+    const QByteArray htmlBytes = "<!--StartFragment--><b>TEST2</b><!--EndFragment-->";
+    TEST( m_test->setClipboard(htmlBytes, "text/html") );
+    RUN(Args("read") << "text/html" << "0", htmlBytes.data());
+
+    RUN(Args("disable"), "");
+    TEST( m_test->setClipboard("TEST3") );
+    RUN(Args("clipboard"), "TEST3");
+    RUN(Args("read") << "text/html" << "0", htmlBytes.data());
+
+    RUN(Args("enable"), "");
+    TEST( m_test->setClipboard("TEST4") );
+    RUN(Args("read") << "0", "TEST4");
+
+    TEST( m_test->stopServer() );
+    m_test->setupTest("CORE", QVariant());
+    TEST( m_test->init() );
+    TEST( m_test->cleanup() );
+}
+
 void Tests::itemToClipboard()
 {
     RUN(Args("add") << "TESTING1" << "TESTING2", "");
@@ -942,6 +1107,11 @@ void Tests::action()
     RUN(Args(args) << "read" << "0", "C");
     RUN(Args(args) << "read" << "1", "B");
     RUN(Args(args) << "read" << "2", "A");
+
+    // action with script evaluated in server
+    RUN(Args(argsAction) << "copyq: print('D' + 'E')" << "", "");
+    WAIT_UNTIL(Args(args) << "size", out == "7\n", out);
+    RUN(Args(args) << "read" << "0", "DE");
 }
 
 void Tests::insertRemoveItems()
@@ -1057,6 +1227,14 @@ void Tests::importExportTab()
 
     RUN(Args(args) << "importtab" << fileName, "");
     RUN(Args(args) << "read" << "0" << "1" << "2" << "3", "jkl\nghi\ndef\nabc");
+
+    // Merge items into existing tab.
+    const QString tab2 = testTab(2);
+    const Args args2 = Args("tab") << tab2;
+    RUN(Args(args2) << "add" << "def" << "xyz", "");
+    RUN(Args(args2) << "importtab" << fileName << tab2, "");
+    RUN(Args(args2) << "size", "5\n");
+    RUN(Args(args2) << "read" << "0" << "1" << "2" << "3" << "4", "xyz\ndef\njkl\nghi\nabc");
 }
 
 void Tests::separator()
@@ -1068,6 +1246,18 @@ void Tests::separator()
     RUN(Args(args) << "read" << "0" << "1" << "2", "ghi\ndef\nabc");
     RUN(Args(args) << "separator" << "," << "read" << "0" << "1" << "2", "ghi,def,abc");
     RUN(Args(args) << "separator" << "---" << "read" << "0" << "1" << "2", "ghi---def---abc");
+
+    // Format applies to all following rows, missing format is empty.
+    RUN(Args(args) << "write" << "text/html" << "<b>HTML</b>", "");
+    RUN(Args(args) << "separator" << ";" << "read" << "text/html" << "0" << "text/plain" << "1" << "2",
+        "<b>HTML</b>;ghi;def");
+    RUN(Args(args) << "read" << "1" << "text/html" << "0" << "2", "ghi\n<b>HTML</b>\n");
+    RUN(Args(args) << "separator" << "," << "read" << "0" << "1", ",ghi");
+
+    // Row -1 is clipboard.
+    TEST( m_test->setClipboard("CLIPBOARD") );
+    RUN(Args("clipboard"), "CLIPBOARD");
+    RUN(Args(args) << "separator" << "," << "read" << "1" << "-1", "ghi,CLIPBOARD");
 }
 
 void Tests::eval()
@@ -1086,6 +1276,49 @@ void Tests::eval()
     RUN(Args("eval") << QString("tab('%1');if (str(read(0)) === 'def') print('ok')").arg(tab2), "ok");
 }
 
+void Tests::evalGlobalsReset()
+{
+    // Script engines are reused but global variables must not leak between commands.
+    for (int i = 0; i < 4; ++i) {
+        RUN(Args("eval") << "typeof leakedVariable", "undefined\n");
+        RUN(Args("eval") << "leakedVariable = 1; var leakedVariable2 = 2; undefined", "");
+        RUN(Args("eval") << "typeof leakedVariable2", "undefined\n");
+    }
+}
+
+void Tests::evalBuiltInsReset()
+{
+    // Changes in built-in objects and prototypes must not leak between commands.
+    for (int i = 0; i < 4; ++i) {
+        RUN(Args("eval") << "typeof ''.leakedProperty + ' ' + typeof Math.leakedProperty", "undefined undefined\n");
+        RUN(Args("eval") << "'a'.toUpperCase()", "A\n");
+        RUN(Args("eval") <<
+            "String.prototype.leakedProperty = 1;"
+            "String.prototype.toUpperCase = function() { return 'X' };"
+            "Math.leakedProperty = 2;"
+            "undefined", "");
+    }
+}
+
+void Tests::byteArrayAppend()
+{
+    RUN(Args("eval") << "b = ByteArray(); b.append('a').append(1).append(frombase64('YmM=')); print(b)", "a1bc");
+    RUN(Args("eval") << "b = ByteArray(); b.append('\\u011b'); b.length", "2\n");
+    RUN(Args("eval") << "b = ByteArray(); b.append('a\\u0000b'); str(b).length", "3\n");
+}
+
+void Tests::byteArrayAppendBenchmark()
+{
+    const QString script =
+            "var b = ByteArray();"
+            "for (var i = 0; i < 20000; ++i) b.append('line ').append(i).append('\\n');"
+            "b.length";
+
+    QBENCHMARK {
+        RUN(Args("eval") << script, "208890\n");
+    }
+}
+
 void Tests::rawData()
 {
     const QString tab = testTab(1);
@@ -1564,6 +1797,12 @@ void Tests::getSetItemCommands()
 
     RUN(Args(args) << "eval" << "print(getitem(1)['text/plain'])", "plain text 2");
     RUN(Args(args) << "eval" << "print(getitem(1)['text/html'])", "<b>HTML text 2</b>");
+
+    // Get multiple items at once.
+    RUN(Args(args) << "eval"
+        << "var items = getitem(1, 0); print(items[0]['text/plain'] + ',' + items[1]['text/plain'])",
+        "plain text 2,plain text");
+    RUN(Args(args) << "read" << "0" << "text/html" << "1", "plain text\n<b>HTML text 2</b>");
 }
 
 void Tests::escapeHTMLCommand()
@@ -1597,6 +1836,845 @@ void Tests::executeCommand()
         , "");
 }
 
+void Tests::commandQueueCommand()
+{
+    QByteArray stdoutActual;
+    TEST( m_test->getClientOutput(Args("commandqueue"), &stdoutActual) );
+
+    const QString output = QString::fromUtf8(stdoutActual);
+    QVERIFY( output.contains(QRegExp("\\binteractive\\b")) );
+    QVERIFY( output.contains(QRegExp("\\bautomatic\\b")) );
+    // Other commands may be still running but at least this one is active.
+    QVERIFY( output.contains(QRegExp("\\bbatch +\\d+ +[1-9]\\d*\\b")) );
+}
+
+void Tests::commandPrioritySource()
+{
+    QObject client1;
+    QObject client2;
+    QString source1;
+    QString source2;
+
+    // Commands from different connections without action or parent process.
+    const Arguments args = clientArguments("", "", "add");
+    QCOMPARE( ScriptableWorkerPool::commandPriority(args, &client1, &source1),
+              ScriptableWorkerPool::Batch );
+    QCOMPARE( ScriptableWorkerPool::commandPriority(args, &client2, &source2),
+              ScriptableWorkerPool::Batch );
+    QVERIFY( source1 != source2 );
+
+    // Commands from clients started by same program.
+    ScriptableWorkerPool::commandPriority(clientArguments("", "101", "add"), &client1, &source1);
+    ScriptableWorkerPool::commandPriority(clientArguments("", "101", "add"), &client2, &source2);
+    QCOMPARE( source1, source2 );
+    ScriptableWorkerPool::commandPriority(clientArguments("", "102", "add"), &client2, &source2);
+    QVERIFY( source1 != source2 );
+
+    // Commands from same action.
+    QCOMPARE( ScriptableWorkerPool::commandPriority(
+                  clientArguments("1", "101", "add"), &client1, &source1),
+              ScriptableWorkerPool::Automatic );
+    ScriptableWorkerPool::commandPriority(clientArguments("1", "102", "add"), &client2, &source2);
+    QCOMPARE( source1, source2 );
+
+    QCOMPARE( ScriptableWorkerPool::commandPriority(
+                  clientArguments("", "101", "show"), &client1, &source1),
+              ScriptableWorkerPool::Interactive );
+}
+
+void Tests::commandStatsCommand()
+{
+    const Args args = Args("tab") << testTab(1);
+
+    QByteArray out;
+    RUN(Args(args) << "action" << "copyq: print('X')" << "", "");
+    WAIT_UNTIL(Args(args) << "size", out == "1\n", out);
+
+    QByteArray stdoutActual;
+    TEST( m_test->getClientOutput(Args("commandstats"), &stdoutActual) );
+
+    const QString output = QString::fromUtf8(stdoutActual);
+    QVERIFY( output.contains(QRegExp("\\bruns\\b")) );
+    QVERIFY( output.contains("print('X')") );
+}
+
+void Tests::actionStatistics()
+{
+    ActionUsage usage;
+    usage.wallTimeMs = 10;
+
+    for (int i = 0; i < 3; ++i)
+        ActionStatistics::record("TEST_A", usage, i == 0);
+
+    // Runs, failed, slow, wall time (avg/max) ... name
+    QString output = ActionStatistics::statistics();
+    QVERIFY( output.contains(QRegExp("\\n +3 +1 +0 +10/10 [^\\n]* TEST_A\\n")) );
+
+    // Least recently used names are removed.
+    for (int i = 0; i < 200; ++i)
+        ActionStatistics::record( "TEST_B" + QString::number(i), usage, false );
+    output = ActionStatistics::statistics();
+    QVERIFY( !output.contains(" TEST_A\n") );
+    QVERIFY( output.contains(" TEST_B0\n") );
+    QVERIFY( output.contains(" TEST_B199\n") );
+
+    ActionStatistics::record("TEST_B0", usage, false);
+    ActionStatistics::record("TEST_C", usage, false);
+    output = ActionStatistics::statistics();
+    QVERIFY( output.contains(QRegExp("\\n +2 +0 +0 [^\\n]* TEST_B0\\n")) );
+    QVERIFY( !output.contains(" TEST_B1\n") );
+    QVERIFY( output.contains(" TEST_C\n") );
+
+#ifdef Q_OS_UNIX
+    // Arguments (item data) are not recorded.
+    Action action;
+    action.setCommand( "true %1", QStringList("TEST_ITEM_TEXT") );
+    action.start();
+    QVERIFY( waitForActions(QList<Action*>() << &action) );
+    output = ActionStatistics::statistics();
+    QVERIFY( !output.contains("TEST_ITEM_TEXT") );
+    QVERIFY( output.contains(QRegExp("\\n +1 +0 +0 [^\\n]* true %1\\n")) );
+#endif
+}
+
+void Tests::profileCommand()
+{
+    RUN(Args("profile") << "reset", "");
+    RUN(Args("profile") << "enable", "");
+    RUN(Args("eval") << "size(); execute('copyq', 'size'); undefined", "");
+
+    QByteArray stdoutActual;
+    TEST( m_test->getClientOutput(Args("profile"), &stdoutActual) );
+    QString output = QString::fromUtf8(stdoutActual);
+    QVERIFY( output.contains(QRegExp("\\btotal +[1-9]")) );
+    QVERIFY( output.contains(QRegExp("\\bsetup +[1-9]")) );
+    QVERIFY( output.contains(QRegExp("\\bqueue_wait +[1-9]")) );
+    QVERIFY( output.contains(QRegExp("\\bprocess +1 ")) );
+    QVERIFY( output.contains(QRegExp("\\bproxy\\.browserSnapshot +[1-9]")) );
+
+    TEST( m_test->getClientOutput(Args("profile") << "json", &stdoutActual) );
+    output = QString::fromUtf8(stdoutActual);
+    QVERIFY( output.startsWith("{\"enabled\":true,") );
+    QVERIFY( output.contains("\"total\":{\"count\":") );
+
+    RUN(Args("profile") << "disable", "");
+    RUN(Args("profile") << "reset", "");
+    RUN(Args("profile") << "json", "{\"enabled\":false,\"metrics\":{}}\n");
+}
+
+void Tests::evalProgramCache()
+{
+    QRegExp re("\\bprogram_cache\\.hits +(\\d+)\\s+program_cache\\.misses +(\\d+)\\b");
+    QByteArray stdoutActual;
+
+    // Program evaluated repeatedly is parsed only once.
+    RUN(Args("profile") << "reset", "");
+    RUN(Args("eval") << "for (var i = 0; i < 3; ++i) eval('cachedProgram = 1'); undefined", "");
+    TEST( m_test->getClientOutput(Args("profile"), &stdoutActual) );
+    QVERIFY( re.indexIn(QString::fromUtf8(stdoutActual)) != -1 );
+    QCOMPARE( re.cap(1).toInt(), 2 );
+    QCOMPARE( re.cap(2).toInt(), 2 ); // outer and inner script
+
+    // Cache is bounded so first program is dropped after evaluating many others.
+    RUN(Args("profile") << "reset", "");
+    RUN(Args("eval") <<
+        "eval('boundedProgram = 0');"
+        "for (var i = 1; i <= 64; ++i) eval('boundedProgram = ' + i);"
+        "eval('boundedProgram = 0'); undefined", "");
+    TEST( m_test->getClientOutput(Args("profile"), &stdoutActual) );
+    QVERIFY( re.indexIn(QString::fromUtf8(stdoutActual)) != -1 );
+    QCOMPARE( re.cap(1).toInt(), 0 );
+    QCOMPARE( re.cap(2).toInt(), 67 );
+
+    RUN(Args("profile") << "reset", "");
+}
+
+void Tests::startProcessCommand()
+{
+    // Read output of two processes line by line while writing input.
+    RUN(Args() << "eval" <<
+        "var p1 = startProcess('copyq', 'eval', 'print(str(input()).toUpperCase())');"
+        "var p2 = startProcess('copyq', 'eval', 'print(str(input()) + \"!\")');"
+        "p1.write('a\\nb'); p1.closeInput();"
+        "p2.write('c'); p2.closeInput();"
+        "print(str(p1.readLine()) + str(p2.read()) + str(p1.readLine()));"
+        "if (p1.readLine() !== undefined) print('unexpected output');"
+        "if (p1.wait() !== 0 || p2.wait() !== 0) print('unexpected exit code');"
+        , "A\nc!B");
+
+#ifdef Q_OS_UNIX
+    // Process writing a lot to standard error output doesn't block.
+    RUN(Args() << "eval" <<
+        "var p = startProcess('sh', '-c', 'head -c 500000 /dev/zero >&2; echo done');"
+        "print(str(p.readLine()) + p.wait() + ' ' + p.readError().length)"
+        , "done\n0 500000");
+#endif
+
+    // Waiting for process can time out.
+    RUN(Args() << "eval" <<
+        "var p = startProcess('copyq', 'eval', 'input()');"
+        "var result = p.wait(200); p.kill(); print(result === undefined)"
+        , "true");
+}
+
+void Tests::subscribeCommand()
+{
+    const QString tab1 = testTab(1);
+    const QString tab2 = testTab(2);
+
+    const QString script = QString(
+        "var p = startProcess('copyq', 'subscribe', 'added', 'removed', 'renamed');"
+        "print(p.readLine());"
+        "tab('%1'); add('abc', 'def'); remove(0);"
+        "renametab('%1', '%2');"
+        "for (var i = 0; i < 4; ++i) print(p.readLine());"
+        "p.kill();"
+        ).arg(tab1, tab2);
+
+    const QString expected = QString(
+        "subscribed\n"
+        "added\t%1\t0\t1\n"
+        "added\t%1\t0\t1\n"
+        "removed\t%1\t0\t1\n"
+        "renamed\t%2\t%1\n"
+        ).arg(tab1, tab2);
+
+    RUN(Args() << "eval" << script, expected);
+
+    TEST( m_test->runClientWithError(Args("subscribe") << "unknown", 1, "Unknown event") );
+}
+
+void Tests::subscribeIgnoresTabReload()
+{
+    const QString tab = testTab(1);
+
+    // Changing configuration unloads tabs, items are loaded again when accessed.
+    const QString script = QString(
+        "tab('%1'); add('A', 'B');"
+        "var p = startProcess('copyq', 'subscribe', 'added', 'removed');"
+        "print(p.readLine());"
+        "var wrap = config('text_wrap');"
+        "config('text_wrap', wrap == 'true' ? 'false' : 'true');"
+        "config('text_wrap', wrap);"
+        "print(read(0, 1)); print('\\n');"
+        "add('C');"
+        "print(p.readLine());"
+        "p.kill();"
+        ).arg(tab);
+
+    const QString expected = QString(
+        "subscribed\n"
+        "B\nA\n"
+        "added\t%1\t0\t1\n"
+        ).arg(tab);
+
+    RUN(Args() << "eval" << script, expected);
+}
+
+void Tests::commandMatcher()
+{
+    QList<Command> commands;
+
+    Command command;
+    command.cmd = "copyq";
+
+    command.re = QRegExp("^http");
+    commands.append(command); // 0
+
+    command.wndre = QRegExp("Browser");
+    commands.append(command); // 1
+
+    command.re = QRegExp();
+    command.wndre = QRegExp("^http"); // same pattern as text regexp of command 0
+    commands.append(command); // 2
+
+    command.wndre = QRegExp();
+    command.input = "image/png";
+    commands.append(command); // 3
+
+    command.input = mimeItems;
+    command.output = "text/plain";
+    commands.append(command); // 4
+
+    command.input = QString();
+    command.output = QString();
+    command.cmd = QString();
+    command.tab = "Tab";
+    commands.append(command); // 5 (only copies item to tab)
+
+    CommandMatcher matcher;
+    matcher.setCommands(commands);
+
+    QVariantMap data;
+    data.insert(mimeText, QByteArray("http://example.com"));
+    data.insert(mimeWindowTitle, QByteArray("Web Browser"));
+    QCOMPARE( matcher.match(data, QString()), QList<int>() << 0 << 1 << 5 );
+    QCOMPARE( matcher.match(data, "Tab"), QList<int>() << 0 << 1 );
+
+    data.insert(mimeWindowTitle, QByteArray("http - Terminal"));
+    QCOMPARE( matcher.match(data, "Tab"), QList<int>() << 0 << 2 );
+
+    data.clear();
+    data.insert("image/png", QByteArray());
+    QCOMPARE( matcher.match(data, "Tab"), QList<int>() << 3 << 4 );
+}
+
+void Tests::clipboardModelSnapshot()
+{
+    ClipboardModel model;
+    model.insertItem( createDataMap(mimeText, QString("A")), 0 );
+    model.insertItem( createDataMap(mimeText, QString("B")), 0 );
+
+    // Snapshot is reused until model changes.
+    const ClipboardModelSnapshotPtr snapshot = model.snapshot();
+    QVERIFY( snapshot->isValid() );
+    QVERIFY( model.snapshot() == snapshot );
+    QCOMPARE( snapshot->size(), 2 );
+    QCOMPARE( snapshotText(snapshot, 0), QByteArray("B") );
+
+    // Insert invalidates snapshot but it still contains consistent old items.
+    model.insertItem( createDataMap(mimeText, QString("C")), 0 );
+    QVERIFY( !snapshot->isValid() );
+    QCOMPARE( snapshot->size(), 2 );
+    QCOMPARE( snapshotText(snapshot, 0), QByteArray("B") );
+    QCOMPARE( snapshotText(snapshot, 1), QByteArray("A") );
+
+    const ClipboardModelSnapshotPtr snapshot2 = model.snapshot();
+    QVERIFY( snapshot2 != snapshot );
+    QVERIFY( snapshot2->isValid() );
+    QCOMPARE( snapshot2->size(), 3 );
+    QCOMPARE( snapshotText(snapshot2, 0), QByteArray("C") );
+
+    // Move.
+    QVERIFY( model.move(0, 2) );
+    QVERIFY( !snapshot2->isValid() );
+    QCOMPARE( snapshotText(snapshot2, 0), QByteArray("C") );
+
+    const ClipboardModelSnapshotPtr snapshot3 = model.snapshot();
+    QVERIFY( snapshot3->isValid() );
+    QCOMPARE( snapshotText(snapshot3, 0), QByteArray("B") );
+    QCOMPARE( snapshotText(snapshot3, 2), QByteArray("C") );
+
+    // Remove.
+    QVERIFY( model.removeRows(0, 1) );
+    QVERIFY( !snapshot3->isValid() );
+    QCOMPARE( snapshot3->size(), 3 );
+
+    const ClipboardModelSnapshotPtr snapshot4 = model.snapshot();
+    QCOMPARE( snapshot4->size(), 2 );
+    QCOMPARE( snapshotText(snapshot4, 0), QByteArray("A") );
+
+    // Script reads changes made earlier in the same script.
+    const Args args = Args("tab") << testTab(1);
+    RUN(Args(args) << "eval" <<
+        "add('A'); var a = str(read(0));"
+        "add('B'); var b = str(read(0)) + str(read(1)) + size();"
+        "remove(0); print(a + b + str(read(0)) + size())",
+        "ABA2A1");
+}
+
+void Tests::clipboardModelInsertItems()
+{
+    ClipboardModel model;
+    model.insertItem( createDataMap(mimeText, QString("A")), 0 );
+
+    QSignalSpy spy( &model, SIGNAL(rowsInserted(QModelIndex,int,int)) );
+
+    QList<QVariantMap> items;
+    items << createDataMap(mimeText, QString("B"))
+          << createDataMap(mimeText, QString("C"))
+          << createDataMap(mimeText, QString("D"));
+    model.insertItems(items, 1);
+
+    // All items are inserted at once and keep their order.
+    QCOMPARE( spy.count(), 1 );
+    QCOMPARE( spy[0][1].toInt(), 1 );
+    QCOMPARE( spy[0][2].toInt(), 3 );
+
+    const ClipboardModelSnapshotPtr snapshot = model.snapshot();
+    QCOMPARE( snapshot->size(), 4 );
+    QCOMPARE( snapshotText(snapshot, 0), QByteArray("A") );
+    QCOMPARE( snapshotText(snapshot, 1), QByteArray("B") );
+    QCOMPARE( snapshotText(snapshot, 2), QByteArray("C") );
+    QCOMPARE( snapshotText(snapshot, 3), QByteArray("D") );
+}
+
+void Tests::commandTester()
+{
+#ifndef Q_OS_UNIX
+    SKIP("Filter programs in this test need POSIX shell");
+#endif
+
+    qRegisterMetaType<Command>("Command");
+
+    CommandTester tester;
+    QSignalSpy spy( &tester, SIGNAL(commandPassed(Command,bool)) );
+    QElapsedTimer t;
+
+    // Number of concurrently running filter programs is limited.
+    QList<Command> commands;
+    for (int i = 0; i < 4; ++i)
+        commands << filterCommand(QString::number(i), "sleep 0.3");
+    tester.setMaxRunning(2);
+    tester.setCommands(commands, QVariantMap());
+    t.start();
+    tester.start();
+    QVERIFY( waitForCommandTester(tester, spy, 4) );
+    QVERIFY( t.elapsed() >= 600 );
+    QCOMPARE( commandTesterResults(spy), QString("0+1+2+3+") );
+
+    // Results are emitted in order of commands even if later filters finish first.
+    spy.clear();
+    commands.clear();
+    commands << filterCommand("A", "sleep 0.5")
+             << filterCommand("B", "sh -c 'exit 1'")
+             << filterCommand("C", "")
+             << filterCommand("D", "true");
+    tester.setMaxRunning(4);
+    tester.setCommands(commands, QVariantMap());
+    tester.start();
+    waitFor(200);
+    QCOMPARE( spy.count(), 0 );
+    QVERIFY( waitForCommandTester(tester, spy, 4) );
+    QCOMPARE( commandTesterResults(spy), QString("A+B-C+D+") );
+
+    // Filter fails after timeout.
+    spy.clear();
+    commands.clear();
+    commands << filterCommand("E", "sleep 10")
+             << filterCommand("F", "true");
+    tester.setTimeout(200);
+    tester.setCommands(commands, QVariantMap());
+    t.start();
+    tester.start();
+    QVERIFY( waitForCommandTester(tester, spy, 2) );
+    QVERIFY( t.elapsed() < 2000 );
+    QCOMPARE( commandTesterResults(spy), QString("E-F+") );
+
+    // Filter which doesn't exit after it's terminated is killed.
+    spy.clear();
+    commands.clear();
+    commands << filterCommand("G", "sh -c 'trap : TERM; while true; do sleep 0.1; done'");
+    tester.setCommands(commands, QVariantMap());
+    t.start();
+    tester.start();
+    QVERIFY( waitForCommandTester(tester, spy, 1) );
+    QVERIFY( t.elapsed() < 4000 );
+    QCOMPARE( commandTesterResults(spy), QString("G-") );
+}
+
+void Tests::commandTesterCache()
+{
+#ifndef Q_OS_UNIX
+    SKIP("Filter programs in this test need POSIX shell");
+#endif
+
+    qRegisterMetaType<Command>("Command");
+
+    // Each started filter program appends a line to the file.
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    const QString fileName = file.fileName();
+
+    QList<Command> commands;
+    commands << filterCommand("A", "sh -c 'echo >> " + fileName + "'")
+             << filterCommand("B", "sh -c 'echo >> " + fileName + "; exit 1'");
+    for (int i = 0; i < commands.size(); ++i)
+        commands[i].cacheMatch = true;
+
+    const QVariantMap data = createDataMap(mimeText, QString("cached"));
+
+    CommandTester tester;
+    QSignalSpy spy( &tester, SIGNAL(commandPassed(Command,bool)) );
+
+    tester.setCommands(commands, data);
+    tester.start();
+    QVERIFY( waitForCommandTester(tester, spy, 2) );
+    QCOMPARE( commandTesterResults(spy), QString("A+B-") );
+    QCOMPARE( file.readAll().count('\n'), 2 );
+
+    // Results for same data are cached.
+    spy.clear();
+    tester.setCommands(commands, data);
+    tester.start();
+    QVERIFY( waitForCommandTester(tester, spy, 2) );
+    QCOMPARE( commandTesterResults(spy), QString("A+B-") );
+    QCOMPARE( file.readAll().count('\n'), 0 );
+
+    // Different data are not cached.
+    spy.clear();
+    tester.setCommands( commands, createDataMap(mimeText, QString("not cached")) );
+    tester.start();
+    QVERIFY( waitForCommandTester(tester, spy, 2) );
+    QCOMPARE( commandTesterResults(spy), QString("A+B-") );
+    QCOMPARE( file.readAll().count('\n'), 2 );
+}
+
+void Tests::coprocess()
+{
+#ifndef Q_OS_UNIX
+    SKIP("Coprocess in this test needs POSIX shell");
+#endif
+
+    // Program replies with its PID and the input record.
+    const QString command =
+            "sh -c 'while read n; do"
+            " d=$(dd bs=1 count=$n 2>/dev/null);"
+            " [ \"$d\" = crash ] && kill -9 $$;"
+            " [ \"$d\" = slow ] && sleep 1;"
+            " r=\"$$ $d\"; echo ${#r}; printf %s \"$r\";"
+            " done'";
+
+    QObject parent;
+
+    // Records are processed by single program and results are received in order.
+    QList<Action*> actions;
+    for (int i = 0; i < 3; ++i)
+        actions << startAction(command, "X" + QByteArray::number(i), true, &parent);
+    QVERIFY( waitForActions(actions) );
+
+    const QByteArray pid = actions[0]->outputData().split(' ').value(0);
+    QVERIFY( !pid.isEmpty() );
+    for (int i = 0; i < 3; ++i) {
+        QVERIFY( !actions[i]->actionFailed() );
+        QCOMPARE( actions[i]->outputData(), pid + " X" + QByteArray::number(i) );
+    }
+
+    // Program is started again after it crashes.
+    Action *crashAction = startAction(command, "crash", true, &parent);
+    QVERIFY( waitForActions(QList<Action*>() << crashAction) );
+    QVERIFY( crashAction->actionFailed() );
+
+    Action *action = startAction(command, "Y", true, &parent);
+    QVERIFY( waitForActions(QList<Action*>() << action) );
+    QVERIFY( !action->actionFailed() );
+    const QByteArray pid2 = action->outputData().split(' ').value(0);
+    QVERIFY( pid2 != pid );
+    QCOMPARE( action->outputData(), pid2 + " Y" );
+
+    // Result of canceled request is not passed to next action.
+    Action *slowAction = startAction(command, "slow", true, &parent);
+    waitFor(100);
+    slowAction->terminate();
+    QVERIFY( !slowAction->isRunning() );
+    QVERIFY( slowAction->actionFailed() );
+
+    action = startAction(command, "Z", true, &parent);
+    QVERIFY( waitForActions(QList<Action*>() << action) );
+    QVERIFY( !action->actionFailed() );
+    QCOMPARE( action->outputData(), pid2 + " Z" );
+
+    // Command with arguments is not passed to coprocess.
+    const QString command2 = "sh -c 'echo $$ %1'";
+    actions.clear();
+    actions << startAction(command2, "A", true, &parent)
+            << startAction(command2, "B", true, &parent);
+    QVERIFY( waitForActions(actions) );
+    const QList<QByteArray> output1 = actions[0]->outputData().trimmed().split(' ');
+    const QList<QByteArray> output2 = actions[1]->outputData().trimmed().split(' ');
+    QCOMPARE( output1.value(1), QByteArray("A") );
+    QCOMPARE( output2.value(1), QByteArray("B") );
+    QVERIFY( output1.value(0) != output2.value(0) );
+}
+
+void Tests::actionOutputSplit()
+{
+#ifndef Q_OS_UNIX
+    SKIP("Commands in this test need POSIX shell");
+#endif
+
+    // Separator split between reads.
+    QCOMPARE( actionOutputItems(
+                  "sh -c 'printf a:; sleep 0.2; printf :b:; sleep 0.2; printf :c'", "::"),
+              QStringList() << "a" << "b" << "c" );
+
+    // Greedy separator at the end of read can continue in next read.
+    QCOMPARE( actionOutputItems(
+                  "sh -c 'printf \"a\\n\"; sleep 0.2; printf \"\\nb\\n\\n\"'", "\\n+"),
+              QStringList() << "a" << "b" );
+
+    // Multi-byte UTF-8 character split between reads.
+    QCOMPARE( actionOutputItems(
+                  "sh -c 'printf \"\\\\303\"; sleep 0.2; printf \"\\\\251,x\"'", ","),
+              QStringList() << QString::fromUtf8("\xc3\xa9") << "x" );
+
+    // Separator matching empty string (items same as from QString::split()).
+    QCOMPARE( actionOutputItems(
+                  "sh -c 'printf a; sleep 0.2; printf b'", "x*"),
+              QStringList() << "" << "a" << "b" );
+}
+
+void Tests::actionLargeInput()
+{
+#ifndef Q_OS_UNIX
+    SKIP("Commands in this test need POSIX shell");
+#endif
+
+    // Input is much larger than pipe capacity.
+    QByteArray input;
+    for (int i = 0; input.size() < 4 * 1024 * 1024; ++i)
+        input.append( QByteArray::number(i) + '\n' );
+
+    Action action;
+    action.setCommand("cat | cat");
+    action.setInput(input);
+    action.setOutputFormat("DATA");
+    action.start();
+
+    // Programs exit only after input channel is closed.
+    QVERIFY( waitForActions(QList<Action*>() << &action) );
+    QVERIFY( !action.actionFailed() );
+    QCOMPARE( action.exitCode(), 0 );
+    QCOMPARE( action.outputData().size(), input.size() );
+    QVERIFY( action.outputData() == input );
+}
+
+void Tests::automaticCommands()
+{
+#ifndef Q_OS_UNIX
+    SKIP("Commands in this test need POSIX shell");
+#endif
+
+    const QString tab1 = testTab(1);
+    const QString tab2 = testTab(2);
+    const QString tab3 = testTab(3);
+
+    QList<QVariantMap> commands;
+
+    // Items are added to same tab in order of commands.
+    commands << automaticCommandSettings("^ORDER", "sh -c 'sleep 0.5; echo A'", tab1);
+    QVariantMap copyCommand = automaticCommandSettings("^ORDER", "", "");
+    copyCommand["Tab"] = tab1;
+    commands << copyCommand
+             << automaticCommandSettings("^ORDER", "echo C", tab1);
+
+    // Ignoring or transforming clipboard cancels following commands.
+    QVariantMap ignoreCommand = automaticCommandSettings("^IGNORE", "true", "");
+    ignoreCommand["Ignore"] = true;
+    QVariantMap transformCommand = automaticCommandSettings("^TRANSFORM", "true", "");
+    transformCommand["Transform"] = true;
+    commands << ignoreCommand << transformCommand
+             << automaticCommandSettings("^(IGNORE|TRANSFORM|KEEP)", "echo B", tab2);
+
+    // Commands for new clipboard wait for commands for previous clipboard.
+    commands << automaticCommandSettings("^FIRST", "sh -c 'sleep 1; echo FIRST'", tab3)
+             << automaticCommandSettings("^SECOND", "echo SECOND", tab3);
+
+    TEST( m_test->stopServer() );
+    m_test->setupTest( "CORE", commandsSettings(commands) );
+    TEST( m_test->init() );
+    TEST( m_test->cleanup() );
+
+    QByteArray out;
+
+    TEST( m_test->setClipboard("ORDER") );
+    WAIT_UNTIL(Args("tab") << tab1 << "size", out == "3\n", out);
+    RUN(Args("tab") << tab1 << "read" << "0" << "1" << "2", "C\nORDER\nA");
+
+    TEST( m_test->setClipboard("IGNORE") );
+    TEST( m_test->setClipboard("TRANSFORM") );
+    TEST( m_test->setClipboard("KEEP") );
+    WAIT_UNTIL(Args("read") << "0", out == "KEEP", out);
+    RUN(Args("read") << "1", "ORDER");
+    RUN(Args("tab") << tab2 << "size", "1\n");
+    RUN(Args("tab") << tab2 << "read" << "0", "B");
+
+    TEST( m_test->setClipboard("FIRST") );
+    TEST( m_test->setClipboard("SECOND") );
+    WAIT_UNTIL(Args("tab") << tab3 << "size", out == "2\n", out);
+    RUN(Args("tab") << tab3 << "read" << "0" << "1", "SECOND\nFIRST");
+
+    TEST( m_test->stopServer() );
+    m_test->setupTest( "CORE", QVariant() );
+    TEST( m_test->init() );
+    TEST( m_test->cleanup() );
+}
+
+void Tests::clipboardChangeCoalescer()
+{
+    qRegisterMetaType<PlatformClipboard::Mode>("PlatformClipboard::Mode");
+    const PlatformClipboard::Mode mode = PlatformClipboard::Clipboard;
+
+    {
+        // Without delay and rate limit, each change is reported immediately.
+        ClipboardChangeCoalescer coalescer;
+        QSignalSpy spy( &coalescer, SIGNAL(changed(PlatformClipboard::Mode)) );
+        coalescer.onChanged(mode);
+        coalescer.onChanged(mode);
+        QCOMPARE( spy.count(), 2 );
+        QCOMPARE( coalescer.coalescedCount(), quint64(0) );
+    }
+
+    {
+        // Burst of changes is reported once after delay.
+        ClipboardChangeCoalescer coalescer;
+        coalescer.setDelay(100);
+        QSignalSpy spy( &coalescer, SIGNAL(changed(PlatformClipboard::Mode)) );
+        coalescer.onChanged(mode);
+        coalescer.onChanged(mode);
+        coalescer.onChanged(mode);
+        QCOMPARE( spy.count(), 0 );
+        waitFor(400);
+        QCOMPARE( spy.count(), 1 );
+        QCOMPARE( coalescer.coalescedCount(), quint64(2) );
+        QCOMPARE( coalescer.droppedCount(), quint64(0) );
+    }
+
+    {
+        // Changes are reported at most twice per second.
+        ClipboardChangeCoalescer coalescer;
+        coalescer.setMaximumRate(2);
+        QSignalSpy spy( &coalescer, SIGNAL(changed(PlatformClipboard::Mode)) );
+        coalescer.onChanged(mode);
+        waitFor(50);
+        QCOMPARE( spy.count(), 1 );
+
+        coalescer.onChanged(mode);
+        coalescer.onChanged(mode);
+        waitFor(100);
+        QCOMPARE( spy.count(), 1 );
+
+        waitFor(800);
+        QCOMPARE( spy.count(), 2 );
+        QCOMPARE( coalescer.droppedCount(), quint64(1) );
+    }
+
+    QByteArray stdoutActual;
+    TEST( m_test->getClientOutput(Args("monitorstats"), &stdoutActual) );
+    QVERIFY( QString::fromUtf8(stdoutActual).contains(QRegExp("^coalesced +\\d+\ndropped +\\d+\n$")) );
+}
+
+void Tests::remoteProcessFailure()
+{
+    RemoteProcess remote;
+    remote.setPingIntervals(100, 1000);
+    QSignalSpy errorSpy( &remote, SIGNAL(connectionError()) );
+
+    const QString name = "copyq_TEST_remote";
+    remote.start( name, QStringList("monitor") << name );
+
+    QElapsedTimer t;
+    t.start();
+    while( !remote.isConnected() && t.elapsed() < 4000 )
+        waitFor(200);
+    QVERIFY( remote.isConnected() );
+
+    // Responsive process answers pings.
+    waitFor(1000);
+    QVERIFY( remote.isConnected() );
+    QCOMPARE( errorSpy.count(), 0 );
+
+#ifdef Q_OS_UNIX
+    const QString pid = QString::number(remote.processId());
+
+    // Stopped process doesn't answer ping.
+    QCOMPARE( QProcess::execute("kill", QStringList() << "-STOP" << pid), 0 );
+    t.start();
+    while( errorSpy.count() == 0 && t.elapsed() < 4000 )
+        waitFor(100);
+    QProcess::execute("kill", QStringList() << "-CONT" << pid);
+    QCOMPARE( errorSpy.count(), 1 );
+    QVERIFY( !remote.isConnected() );
+
+    // Process exit is reported immediately.
+    RemoteProcess remote2;
+    QSignalSpy errorSpy2( &remote2, SIGNAL(connectionError()) );
+    const QString name2 = "copyq_TEST_remote2";
+    remote2.start( name2, QStringList("monitor") << name2 );
+    t.start();
+    while( !remote2.isConnected() && t.elapsed() < 4000 )
+        waitFor(200);
+    QVERIFY( remote2.isConnected() );
+
+    QCOMPARE( QProcess::execute("kill", QStringList() << "-KILL"
+                                << QString::number(remote2.processId())), 0 );
+    t.start();
+    while( errorSpy2.count() == 0 && t.elapsed() < 1000 )
+        waitFor(50);
+    QCOMPARE( errorSpy2.count(), 1 );
+#endif
+}
+
+void Tests::cloneImageDataBenchmark_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("4K") << QSize(3840, 2160);
+    QTest::newRow("8K") << QSize(7680, 4320);
+}
+
+void Tests::cloneImageDataBenchmark()
+{
+    QFETCH(QSize, size);
+
+    // Fake screenshot with some non-trivial content to compress.
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(0xffffffff);
+    for (int y = 0; y < image.height(); y += 16) {
+        for (int x = (y / 16) % 64; x < image.width(); x += 64)
+            image.setPixel(x, y, 0xff000000 | static_cast<uint>(x * y));
+    }
+
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY( image.save(&buffer, "PNG") );
+
+    QMimeData mimeData;
+    mimeData.setData("image/png", png);
+
+    const QStringList formats = QStringList() << "image/png" << "image/bmp" << "image/jpeg";
+
+    QVariantMap data;
+    QBENCHMARK {
+        data = cloneData(mimeData, formats);
+    }
+
+    QCOMPARE( data.value("image/png").toByteArray(), png );
+    QVERIFY( data.contains("image/bmp") );
+    QVERIFY( data.contains("image/jpeg") );
+}
+
+void Tests::clientLatencyBenchmark_data()
+{
+    QTest::addColumn<bool>("cold");
+    QTest::newRow("cold") << true;
+    QTest::newRow("warm") << false;
+}
+
+void Tests::clientLatencyBenchmark()
+{
+    QFETCH(bool, cold);
+
+    if (cold) {
+        // First client after server start.
+        TEST( m_test->stopServer() );
+        TEST( m_test->startServer() );
+        QBENCHMARK_ONCE {
+            QCOMPARE( run(Args("size")), 0 );
+        }
+    } else {
+        QBENCHMARK {
+            QCOMPARE( run(Args("size")), 0 );
+        }
+    }
+}
+
+void Tests::actionSpawnBenchmark()
+{
+#ifdef Q_OS_WIN
+    const QStringList command = QStringList() << "cmd" << "/c" << "exit";
+#else
+    const QStringList command = QStringList() << "true";
+#endif
+
+    QBENCHMARK {
+        Action action;
+        action.setCommand(command);
+        action.start();
+        QVERIFY( action.waitForFinished(5000) );
+    }
+}
+
 int Tests::run(const QStringList &arguments, QByteArray *stdoutData, QByteArray *stderrData, const QByteArray &in)
 {
     return m_test->run(arguments, stdoutData, stderrData, in);
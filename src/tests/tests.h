@@ -58,6 +58,7 @@ private slots:
     void toggleClipboardMonitoring();
 
     void clipboardToItem();
+    void clipboardToItemInProcess();
     void itemToClipboard();
     void tabAddRemove();
     void action();
@@ -66,6 +67,9 @@ private slots:
     void importExportTab();
     void separator();
     void eval();
+    void evalGlobalsReset();
+    void evalBuiltInsReset();
+    void byteArrayAppend();
     void rawData();
 
     void nextPrevious();
@@ -94,6 +98,49 @@ private slots:
     void escapeHTMLCommand();
 
     void executeCommand();
+    void startProcessCommand();
+
+    void commandQueueCommand();
+    void commandPrioritySource();
+
+    void commandStatsCommand();
+    void actionStatistics();
+
+    void profileCommand();
+
+    void evalProgramCache();
+
+    void subscribeCommand();
+    void subscribeIgnoresTabReload();
+
+    void commandMatcher();
+
+    void clipboardModelSnapshot();
+    void clipboardModelInsertItems();
+
+    void commandTester();
+    void commandTesterCache();
+
+    void coprocess();
+
+    void actionOutputSplit();
+    void actionLargeInput();
+
+    void automaticCommands();
+
+    void clipboardChangeCoalescer();
+
+    void remoteProcessFailure();
+
+    void cloneImageDataBenchmark_data();
+    void cloneImageDataBenchmark();
+
+    void clientLatencyBenchmark_data();
+    void clientLatencyBenchmark();
+
+    void actionSpawnBenchmark();
+
+    void byteArrayAppendBenchmark();
 
 private:
     void clearServerErrors();